@@ -11,9 +11,11 @@ INTROSPECT_NS_OPEN;
 struct with_name
 {
 public:
-    with_name(const char* name) :
+    constexpr with_name(const char* name) :
         m_name(name) {}
 
+    constexpr const char* get_name() const { return m_name; }
+
 protected:
     void init(base_field* field) {
         field->m_name = m_name;
@@ -23,6 +25,13 @@ private:
     const char* m_name;
 };
 
+template<>
+struct attr_traits<with_name>
+{
+    static const uint32_t bit = ATTR_NAME;
+    using type = with_name;
+};
+
 //
 // with_default attribute
 //
@@ -36,7 +45,7 @@ template<typename T>
 struct default_value : has_default_value
 {
 public:
-    default_value(const T& value) :
+    constexpr default_value(const T& value) :
         m_value(value) {}
 
     const T& get_default() const { return m_value; }
@@ -72,11 +81,18 @@ private:
 };
 
 template<typename T>
-default_value<T> with_default(const T& value)
+constexpr default_value<T> with_default(const T& value)
 {
     return { value };
 }
 
+template<typename T>
+struct attr_traits<default_value<T>>
+{
+    static const uint32_t bit = ATTR_DEFAULT;
+    using type = has_default_value;
+};
+
 //
 // with_filler attribute
 //
@@ -92,7 +108,7 @@ struct has_filler : has_default_value
 template<typename T>
 struct filler : has_filler
 {
-    filler(const T& value) : 
+    constexpr filler(const T& value) :
         m_value(value) {}
 
     const T& get_filler() const { return m_value; }
@@ -135,11 +151,18 @@ private:
 };
 
 template<typename T>
-filler<T> with_filler(const T& value)
+constexpr filler<T> with_filler(const T& value)
 {
     return { value };
 }
 
+template<typename T>
+struct attr_traits<filler<T>>
+{
+    static const uint32_t bit = ATTR_FILLER;
+    using type = has_filler;
+};
+
 
 //
 // with_min_count attribute
@@ -148,19 +171,110 @@ filler<T> with_filler(const T& value)
 struct with_min_count
 {
 public:
-    explicit with_min_count(size_t min_count) : m_min_count(min_count) {}
+    constexpr explicit with_min_count(size_t min_count) : m_min_count(min_count) {}
     size_t get_min_count() const { return m_min_count; }
 
     has_filler* get_filler() { return m_filler; }
 
 protected:
     void init(has_filler* filler) { m_filler = filler; }
+    void init(vector_mirror*) {} // vectors are resized, fixed arrays need filler
 
 private:
     size_t m_min_count;
     has_filler* m_filler = nullptr;
 };
 
+template<>
+struct attr_traits<with_min_count>
+{
+    static const uint32_t bit = ATTR_MIN_COUNT;
+    using type = with_min_count;
+};
+
+//
+// constraints, checked by validator
+//
+
+template<typename T>
+struct value_range
+{
+public:
+    constexpr value_range(const T& min, const T& max) :
+        m_min(min), m_max(max) {}
+
+    const T& get_min() const { return m_min; }
+    const T& get_max() const { return m_max; }
+
+protected:
+    void init(...) {}
+
+private:
+    T m_min;
+    T m_max;
+};
+
+template<typename T>
+constexpr value_range<T> with_range(const T& min, const T& max)
+{
+    return { min, max };
+}
+
+template<typename T>
+struct attr_traits<value_range<T>>
+{
+    static const uint32_t bit = ATTR_RANGE;
+    using type = value_range<T>;
+};
+
+template<typename T, size_t N>
+struct one_of
+{
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "with_one_of supports integers and enums");
+
+public:
+    array_ptr<const T> get_values() const { return m_values; }
+
+protected:
+    void init(...) {}
+
+private:
+    template<typename U, typename... Args>
+    friend constexpr one_of<U, 1 + sizeof...(Args)> with_one_of(const U& value, const Args&... values);
+
+    T m_values[N];
+};
+
+template<typename T, typename... Args>
+constexpr one_of<T, 1 + sizeof...(Args)> with_one_of(const T& value, const Args&... values)
+{
+    one_of<T, 1 + sizeof...(Args)> attr{};
+    T array[] = { value, static_cast<T>(values)... };
+    for (size_t i = 0; i <= sizeof...(Args); i++)
+        attr.m_values[i] = array[i];
+    return attr;
+}
+
+template<typename T, size_t N>
+struct attr_traits<one_of<T, N>>
+{
+    static const uint32_t bit = ATTR_ONE_OF;
+    using type = one_of<T, N>;
+};
+
+struct with_nonzero
+{
+protected:
+    void init(...) {}
+};
+
+template<>
+struct attr_traits<with_nonzero>
+{
+    static const uint32_t bit = ATTR_NONZERO;
+    using type = with_nonzero;
+};
+
 //
 // maps_to attribute
 //
@@ -168,16 +282,34 @@ private:
 template<typename Struct>
 struct struct_mapping
 {
+    using mapping_type = struct_mapping;
+
     virtual void load_from(const Struct*) = 0;
     virtual void save_into(Struct*) const = 0;
+    // if the field or its nested fields are marked, see base_mirror::marked
+    virtual void save_marked_into(Struct*) const = 0;
+
+    // identifies the mapping in base_mirror::find_mapping
+    static const void *key() {
+        static const char instance = 0;
+        return &instance;
+    }
 };
 
+// the mapping of the field to the struct, or nullptr
+template<typename Struct>
+const struct_mapping<Struct> *mapping_cast(const base_mirror& value)
+{
+    auto *mapping = const_cast<base_mirror&>(value).find_mapping(struct_mapping<Struct>::key());
+    return static_cast<const struct_mapping<Struct> *>(mapping);
+}
+
 template<typename Struct, typename T>
 struct field_mapping : struct_mapping<Struct>
 {
     using field_ptr = T Struct::*;
 
-    field_mapping(field_ptr field) :
+    constexpr field_mapping(field_ptr field) :
         m_that(field) {}
 
     void load_from(const Struct* base) override
@@ -192,11 +324,18 @@ struct field_mapping : struct_mapping<Struct>
             (this->*m_save)(base);
     }
 
+    void save_marked_into(Struct* base) const override
+    {
+        if (m_mirror && has_marked(*m_mirror))
+            save_into(base);
+    }
+
 protected:
     template<typename U, typename F>
     void init(mirror<U, F>* field)
     {
         m_this = field;
+        m_mirror = field;
         m_load = &field_mapping::load<U, F>;
         m_save = &field_mapping::save<U, F>;
     }
@@ -223,6 +362,7 @@ private:
 
     field_ptr   m_that = nullptr;
     void*       m_this = nullptr;
+    const base_mirror* m_mirror = nullptr;
     load_t      m_load = nullptr;
     save_t      m_save = nullptr;
 };
@@ -233,7 +373,7 @@ struct field_mapping<Struct, E[N]> : struct_mapping<Struct>
     using T = E[N];
     using field_ptr = T Struct::*;
 
-    field_mapping(field_ptr field) : 
+    constexpr field_mapping(field_ptr field) :
         m_that(field) {}
 
     void load_from(const Struct* base) override
@@ -248,11 +388,18 @@ struct field_mapping<Struct, E[N]> : struct_mapping<Struct>
             (this->*m_save)(base);
     }
 
+    void save_marked_into(Struct* base) const override
+    {
+        if (m_mirror && has_marked(*m_mirror))
+            save_into(base);
+    }
+
 protected:
     template<typename U>
     void init(mirror<U[N]>* field)
     {
         m_this = field;
+        m_mirror = field;
         m_load = &field_mapping::load<U>;
         m_save = &field_mapping::save<U>;
     }
@@ -283,16 +430,24 @@ private:
 
     field_ptr   m_that = nullptr;
     void *      m_this = nullptr;
+    const base_mirror * m_mirror = nullptr;
     load_t      m_load = nullptr;
     save_t      m_save = nullptr;
 };
 
 template<typename Struct, typename T>
-field_mapping<Struct, T> maps_to(T Struct::* field)
+constexpr field_mapping<Struct, T> maps_to(T Struct::* field)
 {
     return { field };
 }
 
+template<typename Struct, typename T>
+struct attr_traits<field_mapping<Struct, T>>
+{
+    static const uint32_t bit = ATTR_MAPPING;
+    using type = void; // a field may map to several structs, see struct_mapping
+};
+
 template<typename Struct>
 struct nested_mapping : struct_mapping<Struct>
 {
@@ -308,6 +463,12 @@ struct nested_mapping : struct_mapping<Struct>
             (this->*m_save)(base);
     }
 
+    void save_marked_into(Struct* base) const override
+    {
+        if (m_this && m_save_marked && base)
+            (this->*m_save_marked)(base);
+    }
+
 protected:
     template<typename U, typename F>
     void init(mirror<U, F>* field)
@@ -315,6 +476,7 @@ protected:
         m_this = field;
         m_load = &nested_mapping::load<U, F>;
         m_save = &nested_mapping::save<U, F>;
+        m_save_marked = &nested_mapping::save_marked<U, F>;
     }
 
 private:
@@ -333,6 +495,17 @@ private:
         self->save_into(base);
     }
 
+    // the struct assigned as a whole, or its marked fields
+    template<typename U, typename F>
+    void save_marked(Struct* base) const
+    {
+        auto self = static_cast<mirror<U, F>*>(m_this);
+        if (self->marked())
+            self->save_into(base);
+        else
+            self->save_marked_into(base);
+    }
+
 private:
     using load_t = void (nested_mapping::*)(const Struct*);
     using save_t = void (nested_mapping::*)(Struct*) const;
@@ -340,12 +513,20 @@ private:
     void*       m_this = nullptr;
     load_t      m_load = nullptr;
     save_t      m_save = nullptr;
+    save_t      m_save_marked = nullptr;
 };
 
 template<typename Struct>
-nested_mapping<Struct> maps_to()
+constexpr nested_mapping<Struct> maps_to()
 {
     return {};
 }
 
+template<typename Struct>
+struct attr_traits<nested_mapping<Struct>>
+{
+    static const uint32_t bit = ATTR_MAPPING;
+    using type = void; // a field may map to several structs, see struct_mapping
+};
+
 INTROSPECT_NS_CLOSE;
\ No newline at end of file
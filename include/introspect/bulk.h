@@ -0,0 +1,91 @@
+#pragma once
+
+#include "io.h"
+#include "fields.h"
+#include "parallel.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+//
+// bulk loading of records:
+// records are blocks of "path = value" lines, separated by empty lines
+//
+
+struct record_range
+{
+    size_t beg;     // offset of the first byte
+    size_t end;     // offset past the last byte
+    size_t line;    // global number of the first line, 1-based
+};
+
+// find record boundaries in the buffer
+std::vector<record_range> split_records(const char *data, size_t size);
+
+// parse one record into the mirror, line by line
+void parse_record(base_mirror& value, memory_istream& input, const char *data, const record_range& record);
+
+struct record_error : parse_error
+{
+    record_error(size_t line, const std::string& message);
+    size_t line;
+};
+
+// keeps the error with the lowest line number
+class record_errors
+{
+public:
+    void add(const record_error& error);
+    void rethrow() const;
+
+private:
+    std::mutex lock;
+    std::unique_ptr<record_error> first;
+};
+
+static constexpr size_t RECORDS_PER_TASK = 64;
+
+// parse all records of the buffer in parallel into preallocated vector,
+// each worker uses its own mirror rebound to the records;
+// the error in the lowest line is rethrown as record_error
+template<typename Struct, typename Fields = simple_fields>
+void parse_records(const char *data, size_t size, std::vector<Struct>& records, size_t threads = 0)
+{
+    auto ranges = split_records(data, size);
+    // fields omitted by a record keep their defaults, not the old values
+    records.assign(ranges.size(), Struct{});
+
+    record_errors errors;
+    size_t tasks = (ranges.size() + RECORDS_PER_TASK - 1) / RECORDS_PER_TASK;
+    parallel_run(tasks, threads, [&](task_source& source) {
+        mirror<Struct, Fields> value;
+        memory_istream input(data, data);
+        size_t task;
+        while (source.next(task)) {
+            size_t beg = task * RECORDS_PER_TASK;
+            size_t end = std::min(beg + RECORDS_PER_TASK, ranges.size());
+            for (size_t i = beg; i < end; i++) {
+                value.addr(&records[i]);
+                try {
+                    parse_record(value, input, data, ranges[i]);
+                }
+                catch (const record_error& error) {
+                    errors.add(error);
+                }
+            }
+        }
+    });
+    errors.rethrow();
+}
+
+template<typename Struct, typename Fields = simple_fields>
+std::vector<Struct> parse_records(const char *data, size_t size, size_t threads = 0)
+{
+    std::vector<Struct> records;
+    parse_records<Struct, Fields>(data, size, records, threads);
+    return records;
+}
+
+INTROSPECT_NS_CLOSE;
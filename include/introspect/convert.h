@@ -0,0 +1,121 @@
+#pragma once
+
+#include "static_path.h"
+
+#ifdef INTROSPECT_HAS_STATIC_PATH
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+//
+// convert: fields of two structs matched by name at compile time
+// (with_name applied), nested structs and arrays are matched recursively,
+// arithmetic and enum values are converted with static_cast;
+// the result is a sequence of plain assignments, no mirrors involved:
+//
+//   auto other = introspect::convert<other_t>(settings);
+//
+// fields of Dst not found in Src keep their values,
+// extra elements of arrays are ignored; structs are limited
+// to INTROSPECT_MAX_STATIC_FIELDS fields, as for static paths
+//
+
+template<typename T>
+struct static_array_traits
+{
+    static constexpr bool value = false;
+};
+
+template<typename E, size_t N>
+struct static_array_traits<E[N]>
+{
+    static constexpr bool value = true;
+    static constexpr size_t size = N;
+};
+
+template<typename E, size_t N>
+struct static_array_traits<std::array<E, N>>
+{
+    static constexpr bool value = true;
+    static constexpr size_t size = N;
+};
+
+template<typename T>
+struct is_static_vector : std::false_type {};
+
+template<typename E>
+struct is_static_vector<std::vector<E>> : std::true_type {};
+
+template<typename Dst, typename Src>
+void convert_into(Dst& dst, const Src& src);
+
+template<typename Dst, typename Src>
+void convert_value(Dst& dst, const Src& src)
+{
+    using D = typename std::remove_cv<Dst>::type;
+    using S = typename std::remove_cv<Src>::type;
+
+    if constexpr ((std::is_arithmetic<D>::value || std::is_enum<D>::value) &&
+                  (std::is_arithmetic<S>::value || std::is_enum<S>::value))
+        dst = static_cast<D>(src);
+    // before the same types: C arrays are not assignable
+    else if constexpr (static_array_traits<D>::value && static_array_traits<S>::value) {
+        constexpr size_t n = std::min(static_array_traits<D>::size, static_array_traits<S>::size);
+        for (size_t i = 0; i < n; i++)
+            convert_value(dst[i], src[i]);
+    }
+    else if constexpr (std::is_same<D, S>::value)
+        dst = src;
+    else if constexpr (is_static_vector<D>::value && is_static_vector<S>::value) {
+        dst.resize(src.size());
+        for (size_t i = 0; i < src.size(); i++)
+            convert_value(dst[i], src[i]);
+    }
+    else if constexpr (std::is_assignable<D&, const S&>::value)
+        dst = src;
+    else if constexpr (std::is_class<D>::value && std::is_class<S>::value)
+        convert_into(dst, src);
+    else
+        static_assert(std::is_void<Dst>::value, "fields of the same name are not convertible");
+}
+
+// field I of Dst from the field of the same name in Src, if any
+template<size_t I, typename Dst, typename Src>
+void convert_field(Dst& dst, const Src& src)
+{
+    constexpr auto fields = static_field_tuple<Src>();
+    constexpr size_t index = find_static_field(fields, std::get<I>(static_field_tuple<Dst>()).name,
+        std::make_index_sequence<std::tuple_size<decltype(fields)>::value>());
+    if constexpr (index != STATIC_NPOS)
+        convert_value(static_member(dst, std::get<I>(static_field_tuple<Dst>())), static_member(src, std::get<index>(fields)));
+}
+
+template<typename Dst, typename Src, size_t... I>
+void convert_fields(Dst& dst, const Src& src, std::index_sequence<I...>)
+{
+    (convert_field<I>(dst, src), ...);
+}
+
+template<typename Dst, typename Src>
+void convert_into(Dst& dst, const Src& src)
+{
+    constexpr size_t count = std::tuple_size<decltype(static_field_tuple<Dst>())>::value;
+    convert_fields(dst, src, std::make_index_sequence<count>());
+}
+
+template<typename Dst, typename Src>
+Dst convert(const Src& src)
+{
+    Dst dst{};
+    convert_into(dst, src);
+    return dst;
+}
+
+INTROSPECT_NS_CLOSE;
+
+#endif
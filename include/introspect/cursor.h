@@ -0,0 +1,67 @@
+#pragma once
+
+#include "fields.h"
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+//
+// record_cursor: single mirror stepping over contiguous records,
+// fields are linked to the base of the mirror,
+// so moving to the next record is one pointer store
+//
+
+template<typename Struct, typename Fields = simple_fields>
+class record_cursor
+{
+public:
+    record_cursor(Struct *records, size_t count, size_t stride = sizeof(Struct)) :
+        m_records(reinterpret_cast<uint8_t *>(records)), m_count(count), m_stride(stride)
+    {
+        seek(0);
+    }
+
+    explicit record_cursor(std::vector<Struct>& records) :
+        record_cursor(records.data(), records.size()) {}
+
+    size_t count() const { return m_count; }
+    size_t stride() const { return m_stride; }
+    size_t index() const { return m_index; }
+    bool valid() const { return m_index < m_count; }
+
+    void seek(size_t index) {
+        m_index = index;
+        if (valid())
+            m_value.addr(m_records + index * m_stride);
+    }
+
+    // false when moved past the last record
+    bool next() {
+        seek(m_index + 1);
+        return valid();
+    }
+
+    mirror<Struct, Fields>& operator*() { return m_value; }
+    mirror<Struct, Fields> *operator->() { return &m_value; }
+
+    // visit all the records from the first one,
+    // the cursor is left past the last record
+    void visit(visitor& v) {
+        for (seek(0); valid(); next())
+            m_value.visit(v);
+    }
+
+    void visit(const_visitor& v) {
+        for (seek(0); valid(); next())
+            m_value.visit(v);
+    }
+
+private:
+    mirror<Struct, Fields> m_value;
+    uint8_t *   m_records;
+    size_t      m_count;
+    size_t      m_stride;
+    size_t      m_index = 0;
+};
+
+INTROSPECT_NS_CLOSE;
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "schema.h"
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+//
+// dynamic_schema: schema of a struct defined at runtime;
+// fields are laid out in order of addition and aligned like in C struct,
+// so records are contiguous buffers of size() bytes;
+// add all the fields before the schema is used: mirrors, compiled paths
+// and tables made before add_*() don't follow the change and are invalid
+//
+
+class dynamic_schema : public schema
+{
+public:
+    explicit dynamic_schema(const char *name);
+    ~dynamic_schema();
+
+    // count > 1 makes fixed array of the values
+    dynamic_schema& add_int(const char *name, size_t size, bool is_signed = true, size_t count = 1);
+    dynamic_schema& add_bool(const char *name, size_t count = 1);
+    dynamic_schema& add_float(const char *name, size_t size, size_t count = 1);
+    // the options should outlive the schema
+    dynamic_schema& add_enum(const char *name, array_ptr<const enum_option> options, size_t size = sizeof(int), size_t count = 1);
+    dynamic_schema& add_string(const char *name, size_t count = 1);
+    // the nested schema should outlive this one
+    dynamic_schema& add_struct(const char *name, const schema& nested, size_t count = 1);
+
+private:
+    dynamic_schema& add(const char *name, schema_field field, size_t count);
+
+    std::deque<std::string>     m_names;
+    std::vector<schema_field>   m_fields;
+    size_t                      m_size = 0;
+    size_t                      m_align = 1;
+};
+
+//
+// dynamic_struct_mirror: struct_mirror over a value described by schema,
+// with field mirrors created at runtime, so visitors, printer and parser
+// work as for STRUCT_FIELDS; nested fields are also in a flat table,
+// resolve the path once with index_of() and access the field by index
+//
+// std::vector fields are not supported
+//
+
+class dynamic_struct_mirror : public struct_mirror
+{
+public:
+    // own zero-initialized value
+    explicit dynamic_struct_mirror(const schema& schema);
+    // external value, or nullptr to bind it later with addr()
+    dynamic_struct_mirror(const schema& schema, void *addr);
+    ~dynamic_struct_mirror();
+
+    dynamic_struct_mirror(const dynamic_struct_mirror&) = delete;
+    dynamic_struct_mirror& operator=(const dynamic_struct_mirror&) = delete;
+
+    const schema& get_schema() const { return *m_schema; }
+
+    size_t size() const override { return m_schema->size(); }
+    void *addr() override { return m_raw; }
+    void addr(void *addr) override;
+    void link(uint8_t *const *root, ptrdiff_t offset) override;
+    const char *type() const override { return m_schema->name(); }
+
+    field_set<base_field> fields() override;
+    using struct_mirror::fields;
+
+    // fields of this struct and nested ones in depth-first order
+    size_t table_size() const { return m_table.size(); }
+    size_t index_of(const char *path) const;
+    const std::string& path_of(size_t i) const { return m_paths[i]; }
+    base_field& field(size_t i) { return *m_table[i]; }
+    const base_field& field(size_t i) const { return *m_table[i]; }
+
+    // construct and destroy strings of the value
+    static void construct(const schema& schema, void *addr);
+    static void destroy(const schema& schema, void *addr);
+
+private:
+    void relink();
+
+    const schema *                  m_schema;
+    value_ptr<uint8_t>              m_raw;
+    std::unique_ptr<uint8_t[]>      m_buffer;
+    std::vector<std::unique_ptr<base_field>> m_fields;
+    std::vector<field_offset>       m_offsets;
+    std::vector<base_field *>       m_table;
+    std::vector<std::string>        m_paths;
+};
+
+INTROSPECT_NS_CLOSE;
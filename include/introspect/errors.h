@@ -24,4 +24,10 @@ struct bad_key_error : std::out_of_range
     const std::string key;
 };
 
+struct bad_value_error : std::out_of_range
+{
+    bad_value_error(const char *key);
+    const std::string key;
+};
+
 INTROSPECT_NS_CLOSE;
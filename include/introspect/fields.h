@@ -1,6 +1,7 @@
 #pragma once
 
 #include "values.h"
+#include <functional>
 
 INTROSPECT_NS_OPEN;
 
@@ -47,22 +48,72 @@ template<typename T>
 using field_type_t = typename field_type<T>::type;
 
 
+#ifdef INTROSPECT_PROFILE
+// slot of counters for the field by its path from the root struct, see profile.h;
+// size_t(-1) when the slots are exhausted
+size_t heat_slot(const char *root, const char *path, ptrdiff_t offset, size_t size);
+#endif
+
 struct base_field : virtual base_mirror
 {
     base_field(const char *name, ptrdiff_t offset) :
         offset{ offset }, m_name(name)
     {
+    }
+    // copy isn't observed
+    base_field(const base_field& that) :
+        offset{ that.offset }, m_name(that.m_name)
+    {
+#ifdef INTROSPECT_PROFILE
+        heat_slot = that.heat_slot;
+#endif
     }
     virtual ~base_field() {}
 
     const char *name() const { return m_name; }
 
+    void mark_changed() override {
+        for (auto& sink : m_sinks) {
+            if (sink.marks)
+                sink.marks[sink.mark / 64] |= uint64_t(1) << sink.mark % 64;
+        }
+    }
+
+    bool marked() const override {
+        auto& sink = m_sinks[DIRTY_SINK];
+        return sink.marks && (sink.marks[sink.mark / 64] & uint64_t(1) << sink.mark % 64);
+    }
+
+    bool subtree_marked() const override;
+
+#ifdef INTROSPECT_PROFILE
+    void touched() const override;
+    size_t heat_slot = size_t(-1);
+#endif
+
 public:
     const ptrdiff_t offset;
 
+    // mark sinks of observer and dirty_tracker
+    enum { OBSERVER_SINK, DIRTY_SINK, SINK_COUNT };
+
 private:
     friend struct with_name;
+    friend class field_marks;
+    friend void for_each_marked(const struct_mirror& value, const std::function<void(const base_field&)>& fn);
+
+    // bitsets of observer and dirty_tracker, the field is bit mark of each,
+    // its subtree is [mark, end)
+    struct mark_sink
+    {
+        uint64_t *  marks = nullptr;
+        size_t      mark = 0;
+        size_t      end = 0;
+        const field_marks *owner = nullptr;
+    };
+
     const char *m_name;
+    mark_sink   m_sinks[SINK_COUNT];
 };
 
 //
@@ -217,6 +268,61 @@ struct is_struct<std::array<T, N>>
     enum { value = false };
 };
 
+template<typename T>
+struct is_struct<std::vector<T>>
+{
+    enum { value = false };
+};
+
+template<>
+struct is_struct<std::string>
+{
+    enum { value = false };
+};
+
+template<typename T>
+struct is_struct<std::atomic<T>>
+{
+    enum { value = false };
+};
+
+// arrays of structs are mirrored with the same Fields
+
+template<typename T>
+struct is_struct_array
+{
+    enum { value = false };
+};
+
+template<typename T, size_t N>
+struct is_struct_array<T[N]>
+{
+    enum { value = is_struct<T>::value };
+};
+
+template<typename T, size_t N>
+struct is_struct_array<std::array<T, N>>
+{
+    enum { value = is_struct<T>::value };
+};
+
+template<typename T, typename Fields>
+using fields_of = typename std::conditional<
+    is_struct<T>::value || is_struct_array<T>::value, Fields, void>::type;
+
+// union of attr_traits bits
+template<typename... Args>
+struct attr_mask
+{
+    static const uint32_t value = 0;
+};
+
+template<typename Attr, typename... Args>
+struct attr_mask<Attr, Args...>
+{
+    static const uint32_t value = attr_traits<Attr>::bit | attr_mask<Args...>::value;
+};
+
 //
 // simple fields template
 // support for typed fields 
@@ -228,7 +334,7 @@ struct simple_fields
     template <typename T, typename... Args>
     struct field : 
         base_field,
-        mirror<T, typename std::conditional<is_struct<T>::value, simple_fields, void>::type>,
+        mirror<T, fields_of<T, simple_fields>>,
         Args...
     {
         field(const char* name, ptrdiff_t offset, Args... args) :
@@ -236,15 +342,54 @@ struct simple_fields
         {
             int dummy[]{ 0, (Args::init(this), 0)... };
         }
+
+        uint32_t attr_bits() const override { return attr_mask<Args...>::value; }
+
+        void *find_attr(uint32_t bit) override {
+            void *attr = nullptr;
+            int dummy[]{ 0, (attr = attr ? attr : attr_of<Args>(bit), 0)... };
+            return attr;
+        }
+
+        void *find_mapping(const void *key) override {
+            void *mapping = nullptr;
+            int dummy[]{ 0, (mapping = mapping ? mapping : mapping_of<Args>(key, 0), 0)... };
+            return mapping;
+        }
+
+    private:
+        // struct_mapping attributes, found by key
+        template<typename Attr>
+        auto mapping_of(const void *key, int) -> decltype(Attr::key(), (void *)nullptr) {
+            using type = typename Attr::mapping_type;
+            return key == type::key() ? static_cast<type *>(static_cast<Attr *>(this)) : nullptr;
+        }
+
+        template<typename Attr>
+        void *mapping_of(const void *, long) { return nullptr; }
+
+        template<typename Attr>
+        void *attr_of(uint32_t bit) {
+            using type = typename attr_traits<Attr>::type;
+            return (attr_traits<Attr>::bit & bit) ? attr_ptr<Attr>(std::is_void<type>()) : nullptr;
+        }
+
+        template<typename Attr>
+        void *attr_ptr(std::false_type) {
+            return static_cast<typename attr_traits<Attr>::type *>(static_cast<Attr *>(this));
+        }
+
+        // several attributes of the kind, no single one to return
+        template<typename Attr>
+        void *attr_ptr(std::true_type) { return nullptr; }
     };
 
     template<typename Struct>
     struct base
     {
-        void set_fields(Struct& value) {
-            auto m_base = reinterpret_cast<uint8_t*>(&value);
+        void link_fields(uint8_t* const* root, ptrdiff_t offset) {
             for (auto& field : fields<base_field>()) {
-                field.addr(m_base + field.offset);
+                field.link(root, offset + field.offset);
             }
         }
 
@@ -319,9 +464,34 @@ struct struct_mirror : virtual base_mirror
     base_field& operator[](const char* name) { return at(name); }
     const base_field& operator[](const char* name) const { return at(name); }
 
+#ifdef INTROSPECT_PROFILE
+    // slots of the fields by paths from the root, nested mirrors
+    // are assigned by the root, which is the first bound one
+    void assign_heat(const char *root, const std::string& prefix, ptrdiff_t offset);
+    bool heat_assigned = false;
+#endif
+
+    // resolve dotted path of nested fields, like "p.X" or "pts[1].X";
+    // fields in struct arrays are of the shared element mirror,
+    // valid until the next element of the array is accessed
+    base_field& at_path(const char* path);
+
+    const base_field& at_path(const char* path) const {
+        return const_cast<struct_mirror*>(this)->at_path(path);
+    }
+
     VISIT_IMPL;
+    MIRROR_KIND(STRUCT, base_mirror);
 };
 
+// fields of the struct marked for dirty_tracker or with marks in their subtrees,
+// in order of the struct; the set bits of the tracker are scanned, so clean
+// fields are skipped by words
+void for_each_marked(const struct_mirror& value, const std::function<void(const base_field&)>& fn);
+
+template<typename Struct>
+const struct_mapping<Struct> *mapping_cast(const base_mirror& value);
+
 template<typename Struct, typename Fields>
 struct mirror :
     typed_mirror<Struct, struct_mirror>,
@@ -329,19 +499,44 @@ struct mirror :
 {
     static_assert(std::is_class<Struct>::value, "Define partial specialization for your type");
 
-    mirror() = default;
-    mirror(const mirror& that) = default;
-    explicit mirror(Struct& raw) : typed_mirror(raw)
+    // fields are linked to the base of this mirror (or its root),
+    // so addr() of the root mirror is a single store
+
+    mirror() {
+        init_fields();
+    }
+
+    mirror(const mirror& that) :
+        typed_mirror<Struct, struct_mirror>(that), struct_fields<Struct, Fields>(that)
     {
-        set_fields(raw);
+        relink();
+    }
+
+    explicit mirror(Struct& raw) : typed_mirror<Struct, struct_mirror>(raw)
+    {
+        init_fields();
+#ifdef INTROSPECT_PROFILE
+        this->assign_heat(type_name<Struct>(), "", 0);
+#endif
     }
 
     using struct_fields<Struct, Fields>::fields;
     field_set<base_field> fields() override { return fields<base_field>(); }
 
     void addr(void *addr) override {
-        typed_mirror::addr(addr);
-        set_fields(get());
+        bool linked = raw_ptr().linked();
+        typed_mirror<Struct, struct_mirror>::addr(addr);
+        if (linked) // fields followed another root
+            relink();
+#ifdef INTROSPECT_PROFILE
+        if (!this->heat_assigned)
+            this->assign_heat(type_name<Struct>(), "", 0);
+#endif
+    }
+
+    void link(uint8_t *const *root, ptrdiff_t offset) override {
+        typed_mirror<Struct, struct_mirror>::link(root, offset);
+        this->link_fields(root, offset);
     }
 
     template<typename From>
@@ -357,6 +552,117 @@ struct mirror :
         for (auto& mapping : fields<struct_mapping<Into>>())
             mapping.save_into(into);
     }
+
+    // only the fields modified since the marks of dirty_tracker were cleared,
+    // found by the set bits of the tracker
+    template<typename Into>
+    void save_marked_into(Into* into) const
+    {
+        for_each_marked(*this, [into](const base_field& field) {
+            if (auto *mapping = mapping_cast<Into>(field))
+                mapping->save_marked_into(into);
+        });
+    }
+
+    using typed_mirror<Struct, struct_mirror>::raw_ptr;
+
+private:
+    void relink() {
+        this->link_fields(raw_ptr().root(), raw_ptr().offset());
+    }
+
+    void init_fields() {
+        relink();
+    }
+};
+
+//
+// arrays of structs:
+// element() rebinds single shared element mirror, the reference
+// is valid until the next call; operator[] returns own mirror
+// of the element, so several elements can be held at once
+//
+
+struct struct_array_mirror : array_mirror
+{
+    virtual struct_mirror& element(size_t i) = 0;
+
+    // the shared mirror is rebound for const arrays as well
+    const struct_mirror& element(size_t i) const {
+        return const_cast<struct_array_mirror*>(this)->element(i);
+    }
+
+    VISIT_IMPL;
+    MIRROR_KIND(STRUCT_ARRAY, array_mirror);
+};
+
+template<typename Struct, typename Fields>
+struct struct_array : struct_array_mirror
+{
+    struct_array(const struct_array& that) :
+        raw(that.raw), len(that.len)
+    {
+#ifdef INTROSPECT_PROFILE
+        m_element.heat_assigned = true;
+#endif
+    }
+    struct_array(Struct *raw, size_t len) :
+        raw(raw), len(len)
+    {
+#ifdef INTROSPECT_PROFILE
+        m_element.heat_assigned = true; // by the root of the array
+#endif
+    }
+
+    size_t count() const override { return len; }
+    size_t size() const override { return len * sizeof(Struct); }
+    void * addr() override { return raw; }
+    void addr(void *addr) override { raw = reinterpret_cast<Struct *>(addr); }
+    void link(uint8_t *const *root, ptrdiff_t offset) override { raw.link(root, offset); }
+
+    struct_mirror& element(size_t i) override {
+        if (i >= len)
+            throw bad_idx_error(i, len);
+        m_element.addr(raw + i);
+        return m_element;
+    }
+
+    variant operator[](size_t i) override {
+        if (i >= len)
+            throw bad_idx_error(i, len);
+        return mirror_box(std::unique_ptr<base_mirror>(new mirror<Struct, Fields>(*(raw + i))));
+    }
+
+protected:
+    value_ptr<Struct> raw;
+    size_t      len;
+    mirror<Struct, Fields> m_element;
+};
+
+template<typename E, size_t N, typename Fields>
+struct mirror<E[N], Fields> : struct_array<E, Fields>
+{
+    using T = E[N];
+
+    mirror() : struct_array<E, Fields>(nullptr, N) {}
+    mirror(const mirror& that) = default;
+    explicit mirror(T& raw) :
+        struct_array<E, Fields>(raw, N) {}
+
+    T& get() { return *reinterpret_cast<T *>(this->raw.get()); }
+    const T& get() const { return *reinterpret_cast<T *>(this->raw.get()); }
+    const char *type() const override { return type_name<T>(); }
+};
+
+template<typename E, size_t N, typename Fields>
+struct mirror<std::array<E, N>, Fields> : mirror<E[N], Fields>
+{
+    mirror() = default;
+    mirror(const mirror& that) = default;
+    explicit mirror(std::array<E, N>& raw) :
+        mirror<E[N], Fields>(*reinterpret_cast<E(*)[N]>(raw.data())) {}
+
+    const char *type() const override { return type_name<std::array<E, N>>(); }
 };
 
 INTROSPECT_NS_CLOSE;
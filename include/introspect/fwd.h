@@ -5,6 +5,13 @@
 
 #include <stdint.h>
 
+// access profiling of fields, see profile.h
+#ifdef INTROSPECT_PROFILE
+#define INTROSPECT_TOUCH(mirror) (mirror)->touched()
+#else
+#define INTROSPECT_TOUCH(mirror) ((void)0)
+#endif
+
 INTROSPECT_NS_OPEN;
 
 template<typename T, typename Fields = void>
@@ -16,13 +23,17 @@ struct int_mirror;
 struct enum_mirror;
 struct float_mirror;
 struct array_mirror;
+struct vector_mirror;
+struct string_mirror;
 struct struct_mirror;
+struct struct_array_mirror;
 
 struct visitor;
 struct const_visitor;
 
 struct base_field;
 struct base_fields;
+class field_marks;
 
 struct enum_option;
 
@@ -33,6 +44,7 @@ struct has_default_value;
 struct has_filler;
 template<typename T> struct default_value;
 template<typename T> struct filler;
+template<typename Struct> struct struct_mapping;
 
 
 INTROSPECT_NS_CLOSE;
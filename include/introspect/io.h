@@ -1,6 +1,8 @@
 #pragma once
 
 #include "values.h"
+#include <exception>
+#include <functional>
 #include <iostream>
 #include <list>
 
@@ -8,9 +10,16 @@ INTROSPECT_NS_OPEN;
 
 struct context_t
 {
-    using impl_t = std::list<const base_field *>;
+    struct entry
+    {
+        const base_field *field; // nullptr for array index
+        size_t index;
+    };
+
+    using impl_t = std::list<entry>;
 
-    void push(const base_field& field) { names.push_back(&field); }
+    void push(const base_field& field) { names.push_back({ &field, 0 }); }
+    void push(size_t index) { names.push_back({ nullptr, index }); }
     void pop() { names.pop_back(); }
 
     impl_t::const_iterator begin() const { return names.begin(); }
@@ -23,24 +32,90 @@ private:
 
 std::ostream& operator<<(std::ostream& out, const context_t& context);
 
+// text formats of the printer, the parser reads both of them
+enum class text_format
+{
+    PATHS,      // "p.X = 10" line by line
+    GROUPED,    // "p { X = 10, Y = 11 }", nested structs in blocks
+};
+
+// quoted string with escapes
+void print_string(std::ostream& out, const char *str, size_t length);
+
+// the shortest "%g" text that reads back the same value, the same float if single;
+// returns as snprintf does
+int print_float(char *buffer, size_t size, double value, bool single) noexcept;
+
 struct print_visitor : const_visitor
 {
-    explicit print_visitor(std::ostream& str) :
-        out(str) {}
+    // marked_only: the fields modified since the marks of dirty_tracker were cleared
+    explicit print_visitor(std::ostream& str, text_format format = text_format::PATHS, bool marked_only = false) :
+        out(str), grouped(format == text_format::GROUPED), marked_only(marked_only) {}
 
     void visit(const int_mirror& value) override;
     void visit(const float_mirror& value) override;
     void visit(const enum_mirror& value) override;
     void visit(const array_mirror& value) override;
+    void visit(const string_mirror& value) override;
     void visit(const struct_mirror& value) override;
+    void visit(const struct_array_mirror& value) override;
 
 private:
+    void print_fields(const struct_mirror& value);
+    void print_field(const base_field& field);
 
     context_t context;
     std::ostream& out;
+    bool grouped;
+    bool marked_only;
+    size_t blocks = 0;  // nested blocks of GROUPED format
+    bool first = false; // the first field of the block
+
+    // separator of fields in the block
+    const char *begin() {
+        if (!blocks)
+            return "";
+        const char *sep = first ? " " : ", ";
+        first = false;
+        return sep;
+    }
 
     const char *end() const {
-        return context.empty() ? "" : "\n";
+        return context.empty() || blocks ? "" : "\n";
+    }
+};
+
+//
+// memory_istream: input stream over a range of memory,
+// doesn't copy the data, supports tellg/seekg
+//
+
+struct memory_buffer : std::streambuf
+{
+    memory_buffer(const char *beg, const char *end) {
+        auto *ptr = const_cast<char *>(beg);
+        setg(ptr, ptr, ptr + (end - beg));
+    }
+
+protected:
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override;
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+};
+
+// buffer is a base to be constructed before the stream
+struct memory_istream : private memory_buffer, public std::istream
+{
+    memory_istream(const char *beg, const char *end) :
+        memory_buffer(beg, end), std::istream(this) {}
+
+    memory_istream(const char *data, size_t size) :
+        memory_istream(data, data + size) {}
+
+    // switch to another range of memory
+    void reset(const char *beg, const char *end) {
+        auto *ptr = const_cast<char *>(beg);
+        setg(ptr, ptr, ptr + (end - beg));
+        clear();
     }
 };
 
@@ -54,6 +129,7 @@ struct scanner
         NAME,
         INT,
         FLOAT,
+        STRING,
     };
 
     static std::string token_name(int type);
@@ -106,6 +182,9 @@ struct scanner
         return true;
     }
 
+    // the input is over, the EOL tokens are of its end
+    bool at_end() const { return input.eof(); }
+
     template<typename... TokenType>
     token expect(TokenType... token_types) {
         int expected_types[] = { token_types... };
@@ -117,8 +196,10 @@ private:
 
     std::istream& input;
     char token_text[MAX_TOKEN_LENGTH];
+    std::string string_text; // quoted strings are not limited in length
 
     token read();
+    token read_string(position_t pos);
 
     token next_token;
     bool next_read = false;
@@ -142,11 +223,58 @@ struct parse_visitor : visitor
     void visit(enum_mirror& value) override;
     void visit(float_mirror& value) override;
     void visit(array_mirror& value) override;
+    void visit(vector_mirror& value) override;
+    void visit(string_mirror& value) override;
     void visit(struct_mirror& value) override;
+    void visit(struct_array_mirror& value) override;
+
+    // called after every value of the input is parsed, with its path
+    std::function<void(const context_t& context)> on_value;
 
 private:
+    void parse_block(struct_mirror& value);
+    void skip_lines();
+
     scanner input;
     context_t context;
+    bool modified = false; // elements of the current container
+};
+
+//
+// push_parser: resumable parser for incremental input,
+// keeps incomplete line between chunks and applies
+// every "path = value" line as soon as it is complete
+//
+
+struct push_parser
+{
+    explicit push_parser(base_mirror& value) :
+        value(value), input(nullptr, nullptr) {}
+
+    struct result
+    {
+        size_t              applied = 0;    // non-empty lines, blank ones are skipped
+        size_t              failed = 0;     // bad lines
+        std::exception_ptr  error;          // of the first bad line
+    };
+
+    // apply complete lines of the chunk; a bad line doesn't stop the chunk,
+    // it is counted in failed and the rest of lines are applied
+    result feed(const char *data, size_t size);
+
+    // apply the last line, not terminated by end-of-line, returns 1 if it isn't blank;
+    // a bad line throws
+    size_t finish();
+
+    // incomplete line is waiting for more input
+    bool pending() const { return !line.empty(); }
+
+private:
+    void apply(const char *beg, const char *end);
+
+    base_mirror& value;
+    memory_istream input;
+    std::string line;
 };
 
 struct parse_error : std::runtime_error
@@ -182,4 +310,17 @@ inline std::ostream& operator << (std::ostream& str, const base_mirror& value)
     return str;
 }
 
+inline void print(std::ostream& str, const base_mirror& value, text_format format)
+{
+    print_visitor printer(str, format);
+    value.visit(printer);
+}
+
+// the fields modified since the marks of dirty_tracker were cleared
+inline void print_marked(std::ostream& str, const base_mirror& value, text_format format = text_format::PATHS)
+{
+    print_visitor printer(str, format, true);
+    value.visit(printer);
+}
+
 INTROSPECT_NS_CLOSE;
\ No newline at end of file
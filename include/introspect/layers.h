@@ -0,0 +1,129 @@
+#pragma once
+
+#include "io.h"
+#include "fields.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+//
+// field_index: values of a struct in depth-first order, one bit per value
+// in bitmaps of fields; nested structs are expanded into their fields,
+// struct arrays into their elements ("pts[1].X")
+//
+
+class field_index
+{
+public:
+    explicit field_index(struct_mirror& value);
+
+    size_t count() const { return m_paths.size(); }
+    size_t words() const { return (m_paths.size() + 63) / 64; }
+
+    const std::string& path(size_t i) const { return m_paths[i]; }
+    size_t index_of(const char *path) const;
+
+    // parse the input into the value, the bits of the parsed values are set
+    void parse(struct_mirror& value, std::istream& input, uint64_t *bits) const;
+
+    // assign the values with the bits from the mirror of the same type
+    void copy(struct_mirror& dst, const struct_mirror& src, const uint64_t *bits) const;
+
+private:
+    void add_paths(struct_mirror& value, const std::string& prefix);
+
+    std::vector<std::string> m_paths;
+    std::unordered_map<std::string, size_t> m_index;
+};
+
+// assign the value of the mirror of the same type: scalars, strings and arrays of them
+void assign(base_mirror& dst, const base_mirror& src);
+
+//
+// layered_loader: config assembled from layers of text, like base,
+// environment and host overrides; every layer is parsed into its own value
+// and a bitmap of the fields it sets, then the layers are merged
+// with word-wide bitmap operations, the last added layer wins
+//
+
+static constexpr size_t NO_LAYER = size_t(-1);
+
+template<typename Struct, typename Fields = simple_fields>
+class layered_loader
+{
+public:
+    layered_loader() : m_index(layout()) {}
+
+    const field_index& index() const { return m_index; }
+    size_t layers() const { return m_layers.size(); }
+    const std::string& name(size_t layer) const { return m_layers[layer]->name; }
+
+    // add the layer over the previous ones, returns its index
+    size_t add_layer(const char *name, std::istream& input) {
+        std::unique_ptr<layer> added(new layer());
+        added->name = name;
+        added->bits.resize(m_index.words());
+        mirror<Struct, Fields> value(added->value);
+        m_index.parse(value, input, added->bits.data());
+        m_layers.push_back(std::move(added));
+        return m_layers.size() - 1;
+    }
+
+    size_t add_layer(const char *name, const char *text) {
+        memory_istream input(text, strlen(text));
+        return add_layer(name, input);
+    }
+
+    // every field is taken from the last layer that sets it,
+    // fields not set by any layer keep their values
+    void merge(Struct& value) const {
+        std::vector<uint64_t> taken(m_index.words()), bits(m_index.words());
+        mirror<Struct, Fields> dst(value), src;
+        for (size_t i = m_layers.size(); i-- > 0;) {
+            auto& from = *m_layers[i];
+            uint64_t any = 0;
+            for (size_t w = 0; w < taken.size(); w++) {
+                bits[w] = from.bits[w] & ~taken[w];
+                taken[w] |= from.bits[w];
+                any |= bits[w];
+            }
+            if (any) {
+                src.addr(&from.value);
+                m_index.copy(dst, src, bits.data());
+            }
+        }
+    }
+
+    // index of the layer the value is taken from, or NO_LAYER
+    size_t provenance(const char *path) const {
+        size_t i = m_index.index_of(path);
+        for (size_t l = m_layers.size(); l-- > 0;) {
+            if (m_layers[l]->bits[i / 64] & uint64_t(1) << i % 64)
+                return l;
+        }
+        return NO_LAYER;
+    }
+
+private:
+    struct layer
+    {
+        std::string             name;
+        Struct                  value{};
+        std::vector<uint64_t>   bits;
+    };
+
+    // the fields of the type
+    static field_index layout() {
+        Struct value{};
+        mirror<Struct, Fields> fields(value);
+        return field_index(fields);
+    }
+
+    field_index m_index;
+    std::vector<std::unique_ptr<layer>> m_layers;
+};
+
+INTROSPECT_NS_CLOSE;
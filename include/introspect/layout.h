@@ -0,0 +1,52 @@
+#pragma once
+
+#include "schema.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+//
+// layout report: padding holes, cache line straddles
+// and suggested order of fields, built from the schema
+//
+
+struct layout_entry
+{
+    std::string path;       // "p.X", "pts[]." for elements of struct arrays
+    ptrdiff_t   offset;     // from the root struct
+    size_t      size;
+    size_t      align;
+    bool        padding;    // hole before the next field or the end of struct
+    bool        straddles;  // crosses cache line, though fits into one; in any element of arrays
+};
+
+struct layout_report
+{
+    std::string name;
+    size_t      size;
+    size_t      align;
+    size_t      cache_line;
+
+    std::vector<layout_entry> entries;  // fields and holes in order of offset
+    size_t      wasted;                 // bytes of padding, including nested structs
+
+    // fields of the root struct: hot fields first,
+    // then by alignment and size, descending
+    std::vector<std::string> suggested;
+    size_t      suggested_size;
+};
+
+layout_report analyze_layout(const schema& schema, size_t cache_line = 64,
+    const std::vector<std::string>& hot = {});
+
+template<typename Struct>
+layout_report analyze_layout(size_t cache_line = 64, const std::vector<std::string>& hot = {})
+{
+    return analyze_layout(schema::of<Struct>(), cache_line, hot);
+}
+
+std::ostream& operator<<(std::ostream& out, const layout_report& report);
+
+INTROSPECT_NS_CLOSE;
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "io.h"
+#include "fields.h"
+#include <map>
+#include <string>
+
+INTROSPECT_NS_OPEN;
+
+//
+// lazy_document
+// indexes "path = value" lines of a document in one pass
+// and parses the value of a field only on first access;
+// blocks of the grouped format are rejected
+//
+
+class lazy_document
+{
+public:
+    lazy_document(std::string text, struct_mirror& root);
+    lazy_document(std::istream& str, struct_mirror& root);
+
+    // parse field (if not parsed yet) and return it, nested struct with
+    // all of its fields; bad_key_error if the document has no such path
+    base_field& at(const char *path);
+    base_field& operator[](const char *path) { return at(path); }
+
+    // parse field or all fields of nested struct
+    void materialize(const char *path);
+
+    // parse all remaining fields
+    void materialize();
+
+    bool contains(const char *path) const;
+    size_t size() const { return index.size(); }
+    size_t parsed() const { return parsed_count; }
+
+private:
+
+    struct entry
+    {
+        size_t beg;
+        size_t end;
+        bool parsed;
+    };
+
+    using index_t = std::map<std::string, entry>;
+
+    void build_index();
+    bool has_prefix(const char *path) const;
+    void parse(const std::string& path, entry& value);
+
+    std::string text;
+    struct_mirror& root;
+    index_t index;
+    size_t parsed_count = 0;
+};
+
+INTROSPECT_NS_CLOSE;
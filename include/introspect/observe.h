@@ -0,0 +1,151 @@
+#pragma once
+
+#include "fields.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+//
+// field_marks: bitset of the fields of a mirrored struct in depth-first order,
+// attached to one mark sink of the fields; observer and dirty_tracker keep
+// their own bitsets, so they work side by side on the same mirror
+//
+
+class field_marks
+{
+public:
+    field_marks(const field_marks&) = delete;
+    field_marks& operator=(const field_marks&) = delete;
+
+    // any changes since the last reset
+    bool pending() const;
+
+    // drop the changes
+    void reset();
+
+protected:
+    friend void for_each_marked(const struct_mirror& value, const std::function<void(const base_field&)>& fn);
+
+    // the mirror should outlive the marks; a later bitset on the same sink
+    // takes the fields over
+    field_marks(struct_mirror& root, size_t sink);
+    ~field_marks();
+
+    // fields in depth-first order, subtree of node i is [i, end)
+    struct node
+    {
+        std::string path;
+        base_field *field;
+        size_t      end;
+        size_t      parent;
+    };
+
+    static const size_t NO_PARENT = size_t(-1);
+
+    void add_nodes(struct_mirror& value, const std::string& prefix, size_t parent);
+    void attach(base_field& field, size_t mark, size_t end);
+    void attach_nested(struct_mirror& value, size_t mark);
+    size_t find(const char *path) const;
+    std::vector<std::string> marked_paths(const std::vector<uint64_t>& marks) const;
+
+    // the first set bit in [i, end), or end
+    static size_t next_marked(const std::vector<uint64_t>& marks, size_t i, size_t end);
+
+    static bool test(const std::vector<uint64_t>& marks, size_t i) {
+        return 0 != (marks[i / 64] & (uint64_t(1) << i % 64));
+    }
+
+    std::vector<node>       m_nodes;
+    std::vector<uint64_t>   m_marks;
+    size_t                  m_sink;
+};
+
+//
+// observer: change subscriptions for fields of a mirrored struct;
+// fields mark themselves in a bitset when their value changes
+// (set(), int_value(), parsing, ...), and dispatch() calls
+// every subscriber of the changed fields once per batch
+//
+
+class observer;
+
+// fields changed in the batch
+class change_set
+{
+public:
+    // the field, its subtree or its parent struct is changed
+    bool contains(const char *path) const;
+
+    // paths of the changed fields
+    std::vector<std::string> paths() const;
+
+private:
+    friend class observer;
+
+    change_set(const observer& owner, const std::vector<uint64_t>& marks) :
+        m_owner(owner), m_marks(marks) {}
+
+    const observer& m_owner;
+    const std::vector<uint64_t>& m_marks;
+};
+
+class observer : public field_marks
+{
+public:
+    using callback = std::function<void(const change_set&)>;
+
+    // the mirror should outlive the observer
+    explicit observer(struct_mirror& root) :
+        field_marks(root, base_field::OBSERVER_SINK) {}
+
+    // subscribe to the field or subtree, empty path for all fields;
+    // returns id of subscription
+    size_t subscribe(const char *path, callback fn);
+    void unsubscribe(size_t id);
+
+    // call subscribers of the changed fields once, and start new batch;
+    // changes made by callbacks go to the next batch
+    void dispatch();
+
+private:
+    friend class change_set;
+
+    struct subscription
+    {
+        size_t      id;
+        size_t      beg;
+        size_t      end;
+        callback    fn;
+    };
+
+    bool changed(const std::vector<uint64_t>& marks, size_t beg, size_t end) const;
+
+    std::vector<subscription>   m_subscriptions;
+    size_t                      m_next_id = 0;
+};
+
+//
+// dirty_tracker: opt-in tracking of the fields modified since clear_dirty(),
+// to save or replicate only them with print_marked() and save_marked_into(),
+// which follow the set bits; the marks are apart from the observer,
+// dispatch() doesn't clear them; writes through elements of
+// array_mirror::operator[] are not seen, use set(i, value) of the array
+//
+
+class dirty_tracker : public field_marks
+{
+public:
+    explicit dirty_tracker(struct_mirror& root) :
+        field_marks(root, base_field::DIRTY_SINK) {}
+
+    bool dirty() const { return pending(); }
+
+    // paths of the modified fields, structs assigned as a whole included
+    std::vector<std::string> dirty_paths() const { return marked_paths(m_marks); }
+
+    void clear_dirty() { reset(); }
+};
+
+INTROSPECT_NS_CLOSE;
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "schema.h"
+#include <string>
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+//
+// packed_codec: records as a bitstream, each scalar in as few bits
+// as its declared values need: with_range and with_one_of bound the integers,
+// enum_options bound the enums, bools take one bit;
+// other integers and floats keep their full width
+//
+// records are packed one after another, record i starts at bit i * bits(),
+// so any field of any record is read without unpacking the others
+//
+
+struct packed_field;
+
+// the field of count records, the first one at the index in the stream
+using pack_fn = bool (*)(const packed_field& field, const uint8_t *records, size_t count, size_t stride,
+    uint64_t *stream, size_t index, size_t record_bits);
+using unpack_fn = void (*)(const packed_field& field, const uint64_t *stream, size_t index, size_t record_bits,
+    uint8_t *records, size_t count, size_t stride);
+
+struct packed_field
+{
+    std::string     path;
+    const schema_field *field;
+    ptrdiff_t       offset;     // from the record base
+    size_t          bit;        // from the start of the packed record
+    uint32_t        bits;
+    int64_t         min;        // integers are stored as value - min,
+    uint64_t        range;      // from 0 to range
+    pack_fn         pack;       // returns true if some value is out of range
+    unpack_fn       unpack;
+};
+
+class packed_codec
+{
+public:
+    explicit packed_codec(const schema& schema);
+
+    template<typename Struct>
+    static const packed_codec& of() {
+        static const packed_codec instance(schema::of<Struct>());
+        return instance;
+    }
+
+    const schema& get_schema() const { return *m_schema; }
+
+    // scalars, array elements included, in order of the schema
+    size_t count() const { return m_fields.size(); }
+    const packed_field& operator[](size_t i) const { return m_fields[i]; }
+    size_t index_of(const char *path) const;
+
+    // bits of one record, and 64-bit words of the stream of count records
+    size_t bits() const { return m_bits; }
+    size_t words(size_t count) const { return (count * m_bits + 63) / 64; }
+
+    // one record at the index, other records of the stream are kept;
+    // throws bad_value_error if a value is out of the range, the record is then incomplete
+    void pack(const void *record, uint64_t *stream, size_t index) const;
+    void unpack(const uint64_t *stream, size_t index, void *record) const;
+
+    // records of the span field by field, the stream has words(count) words
+    void pack(const void *records, size_t count, size_t stride, uint64_t *stream) const;
+    void unpack(const uint64_t *stream, size_t count, void *records, size_t stride) const;
+
+    // single field of the record at the index
+    int64_t get_int(const uint64_t *stream, size_t index, size_t field) const;
+    void set_int(uint64_t *stream, size_t index, size_t field, int64_t value) const;
+    double get_float(const uint64_t *stream, size_t index, size_t field) const;
+    void set_float(uint64_t *stream, size_t index, size_t field, double value) const;
+
+private:
+    void add_field(const schema_field& field, ptrdiff_t offset, const std::string& path);
+
+    const schema *  m_schema;
+    std::vector<packed_field> m_fields;
+    size_t          m_bits = 0;
+};
+
+//
+// packed_vector: records stored in the bitstream
+//
+
+template<typename Struct>
+class packed_vector
+{
+public:
+    packed_vector() : m_codec(&packed_codec::of<Struct>()) {}
+
+    explicit packed_vector(const std::vector<Struct>& records) : packed_vector() {
+        assign(records.data(), records.size());
+    }
+
+    const packed_codec& codec() const { return *m_codec; }
+    size_t size() const { return m_count; }
+    size_t memory() const { return m_stream.size() * sizeof(uint64_t); }
+
+    void assign(const Struct *records, size_t count) {
+        m_count = count;
+        m_stream.resize(m_codec->words(count));
+        m_codec->pack(records, count, sizeof(Struct), m_stream.data());
+    }
+
+    void push_back(const Struct& value) {
+        m_stream.resize(m_codec->words(m_count + 1));
+        m_codec->pack(&value, m_stream.data(), m_count);
+        m_count++;
+    }
+
+    Struct operator[](size_t i) const {
+        Struct value{};
+        m_codec->unpack(m_stream.data(), i, &value);
+        return value;
+    }
+
+    void set(size_t i, const Struct& value) { m_codec->pack(&value, m_stream.data(), i); }
+
+    int64_t get_int(size_t i, size_t field) const { return m_codec->get_int(m_stream.data(), i, field); }
+    void set_int(size_t i, size_t field, int64_t value) { m_codec->set_int(m_stream.data(), i, field, value); }
+    double get_float(size_t i, size_t field) const { return m_codec->get_float(m_stream.data(), i, field); }
+    void set_float(size_t i, size_t field, double value) { m_codec->set_float(m_stream.data(), i, field, value); }
+
+private:
+    const packed_codec *    m_codec;
+    std::vector<uint64_t>   m_stream;
+    size_t                  m_count = 0;
+};
+
+INTROSPECT_NS_CLOSE;
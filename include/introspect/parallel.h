@@ -0,0 +1,47 @@
+#pragma once
+
+#include "fwd.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+
+INTROSPECT_NS_OPEN;
+
+//
+// task_source: task indices for one worker of parallel_run,
+// every worker starts with its own contiguous range of tasks
+// and steals tasks from the others when the range is exhausted
+//
+
+class task_source
+{
+public:
+    // get next task index, false when all tasks are taken
+    bool next(size_t& task);
+
+    size_t worker() const { return m_worker; }
+
+private:
+    friend void parallel_run(size_t, size_t, const std::function<void(task_source&)>&);
+
+    // a cache line each, the workers don't share them
+    struct alignas(64) range
+    {
+        std::atomic<size_t> next;
+        size_t end;
+    };
+
+    task_source(range *ranges, size_t count, size_t worker) :
+        m_ranges(ranges), m_count(count), m_worker(worker), m_victim(worker) {}
+
+    range * m_ranges;
+    size_t  m_count;
+    size_t  m_worker;
+    size_t  m_victim;
+};
+
+// run worker on each of threads (0 - hardware concurrency) for tasks [0, count),
+// the first exception thrown by a worker is rethrown after all of them finish
+void parallel_run(size_t count, size_t threads, const std::function<void(task_source&)>& worker);
+
+INTROSPECT_NS_CLOSE;
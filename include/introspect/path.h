@@ -0,0 +1,67 @@
+#pragma once
+
+#include "schema.h"
+
+INTROSPECT_NS_OPEN;
+
+//
+// compiled paths: "p.X" or "pts[1].X" resolved once
+// to the offset from the struct base and the conversion functions,
+// so access through the path is a single load or store
+//
+
+struct path_accessor
+{
+    const schema_field *field;
+    ptrdiff_t   offset;     // from the base of the root struct
+    value_kind  kind;       // INT, ENUM or FLOAT
+
+    int64_t (*load_int)(const void *value);
+    void    (*store_int)(void *value, int64_t);
+    double  (*load_float)(const void *value);
+    void    (*store_float)(void *value, double);
+
+    int64_t get_int(const void *base) const { return load_int(static_cast<const uint8_t *>(base) + offset); }
+    void set_int(void *base, int64_t value) const { store_int(static_cast<uint8_t *>(base) + offset, value); }
+    double get_float(const void *base) const { return load_float(static_cast<const uint8_t *>(base) + offset); }
+    void set_float(void *base, double value) const { store_float(static_cast<uint8_t *>(base) + offset, value); }
+};
+
+// resolve the path of a scalar value in the schema,
+// accessors are cached per schema generation and live as long as the program,
+// or until forget_paths() for dynamic schemas
+const path_accessor& compile_path(const schema& schema, const char *path);
+
+// drop the accessors of the schema, when it is changed or destroyed
+void forget_paths(const schema& schema);
+
+// accessor bound to the mirror, follows its rebinding with addr()
+class compiled_path
+{
+public:
+    compiled_path(const path_accessor& access, uint8_t *const *root, ptrdiff_t offset) :
+        m_access(&access), m_root(root), m_offset(offset + access.offset) {}
+
+    const path_accessor& accessor() const { return *m_access; }
+    value_kind kind() const { return m_access->kind; }
+    void *addr() const { return *m_root + m_offset; }
+
+    int64_t get_int() const { return m_access->load_int(*m_root + m_offset); }
+    void set_int(int64_t value) const { m_access->store_int(*m_root + m_offset, value); }
+    double get_float() const { return m_access->load_float(*m_root + m_offset); }
+    void set_float(double value) const { m_access->store_float(*m_root + m_offset, value); }
+
+private:
+    const path_accessor *m_access;
+    uint8_t *const *    m_root;
+    ptrdiff_t           m_offset;
+};
+
+template<typename Struct, typename Fields>
+compiled_path compile_path(const mirror<Struct, Fields>& value, const char *path)
+{
+    auto& ptr = value.raw_ptr();
+    return{ compile_path(schema::of<Struct>(), path), ptr.root(), ptr.offset() };
+}
+
+INTROSPECT_NS_CLOSE;
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "fields.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+//
+// heat profiling of field access, enabled by INTROSPECT_PROFILE:
+// get(), set(), int_value(), float_value(), str_value() and visit()
+// of fields increment per-thread counters of the field,
+// counters of all the threads are summed up by heat_report();
+// the fields are counted by their paths from the root struct,
+// so "p.X" and "s.X" are apart, elements of struct arrays share "pts[].X"
+//
+
+struct heat_entry
+{
+    std::string type;   // root struct type
+    std::string name;   // path from the root, like "p.X"
+    ptrdiff_t   offset; // from the root
+    size_t      size;
+    uint64_t    count;
+};
+
+// counters of all the fields, the hottest first;
+// empty if INTROSPECT_PROFILE is not defined
+std::vector<heat_entry> heat_report();
+
+// some fields are not counted: there are more of them than the slots
+bool heat_overflow();
+
+// zero the counters
+void reset_heat();
+
+std::ostream& operator<<(std::ostream& out, const std::vector<heat_entry>& report);
+
+INTROSPECT_NS_CLOSE;
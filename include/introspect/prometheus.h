@@ -0,0 +1,45 @@
+#pragma once
+
+#include "fields.h"
+#include <string>
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+//
+// prometheus_exporter: values of a stats struct in Prometheus text
+// exposition format; metric names ("prefix_p_X", "prefix_a{index=\"1\"}")
+// are rendered once, so a scrape only formats the numbers
+//
+// scalars of nested structs and fixed arrays are exported,
+// strings, vectors and struct arrays are skipped
+//
+
+class prometheus_exporter
+{
+public:
+    // the mirror should outlive the exporter
+    explicit prometheus_exporter(const struct_mirror& stats, const char *prefix = "");
+
+    size_t count() const { return m_metrics.size(); }
+
+    // render all the metrics, the buffer is reused by the next scrape
+    const std::string& scrape();
+
+private:
+    static const size_t NO_INDEX = size_t(-1);
+
+    struct metric
+    {
+        std::string         name;   // with labels and trailing space
+        const base_mirror * value;  // scalar, or array for index
+        size_t              index;
+    };
+
+    void add_metrics(const struct_mirror& value, const std::string& prefix);
+
+    std::vector<metric> m_metrics;
+    std::string         m_buffer;
+};
+
+INTROSPECT_NS_CLOSE;
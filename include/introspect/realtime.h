@@ -0,0 +1,80 @@
+#pragma once
+
+#include "path.h"
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+//
+// real-time subset: parse, print and apply of "path = value" deltas
+// for threads where allocations and exceptions are banned; the lines are
+// of the text format of print() and parse(), so either side reads the other;
+// rt_table resolves the paths beforehand, off the real-time thread,
+// then the calls below work in fixed buffers and return status codes,
+// they never allocate nor throw
+//
+
+enum class rt_status : uint8_t
+{
+    OK,
+    SYNTAX_ERROR,   // not a "path = value" line
+    UNKNOWN_PATH,   // not in the table
+    BAD_VALUE,      // not a number, unknown enum option, out of the range of the type
+    BUFFER_FULL,    // the output doesn't fit
+};
+
+const char *rt_status_name(rt_status status) noexcept;
+
+class rt_table
+{
+public:
+    // all scalar values and arrays of them in the schema, struct array elements
+    // included ("a", "pts[0].X"); strings and vectors are left out: assigning them may allocate
+    explicit rt_table(const schema& schema);
+
+    // only the listed paths of scalar values or arrays of them
+    rt_table(const schema& schema, std::initializer_list<const char *> paths);
+
+    size_t count() const { return m_entries.size(); }
+    const char *path(size_t i) const { return m_entries[i].path.c_str(); }
+    // of the value, or of the first element of the array
+    const path_accessor& accessor(size_t i) const { return *m_entries[i].access; }
+
+    // nullptr if not found, binary search without allocations
+    const path_accessor *find(const char *path, size_t length) const noexcept;
+
+private:
+    struct entry
+    {
+        std::string         path;
+        const path_accessor *access;
+    };
+
+    void add(const schema& schema, const char *path);
+    void sort();
+
+    std::vector<entry>  m_entries;  // in order of the schema
+    std::vector<size_t> m_sorted;   // entries by path
+};
+
+// apply one line "path = value" to the struct, arrays as "a = { 1, 2, 3 }"
+// with all of the elements
+rt_status rt_apply(const rt_table& table, void *base, const char *line, size_t length) noexcept;
+
+// apply lines of the text, empty ones are skipped; a bad line doesn't stop
+// the text, the first error is returned after the rest of lines are applied
+rt_status rt_apply_delta(const rt_table& table, void *base, const char *text, size_t size,
+    size_t *applied = nullptr) noexcept;
+
+// print "path = value" line of the entry i into the buffer, as the printer does,
+// floats with the shortest precision that reads back the same value
+rt_status rt_print(const rt_table& table, size_t i, const void *base, char *buffer, size_t size,
+    size_t *written) noexcept;
+
+// print all entries of the table, written counts the complete lines only
+rt_status rt_print(const rt_table& table, const void *base, char *buffer, size_t size,
+    size_t *written) noexcept;
+
+INTROSPECT_NS_CLOSE;
@@ -0,0 +1,450 @@
+#pragma once
+
+#include "fields.h"
+#include "attrib.h"
+#include <functional>
+#include <iostream>
+#include <string>
+
+INTROSPECT_NS_OPEN;
+
+//
+// schema: shared immutable descriptor of a struct,
+// built once per type from its STRUCT_FIELDS
+//
+
+enum class value_kind : uint8_t
+{
+    NONE,
+    INT,
+    ENUM,
+    FLOAT,
+    STRING,
+    ARRAY,      // fixed array, see item_kind
+    VECTOR,     // std::vector, see item_kind
+    STRUCT,
+};
+
+enum field_flags : uint8_t
+{
+    HAS_DEFAULT     = 1 << 0,
+    HAS_FILLER      = 1 << 1,
+    HAS_MIN_COUNT   = 1 << 2,
+    IS_BOOL         = 1 << 3,
+    HAS_RANGE       = 1 << 4,
+    HAS_ONE_OF      = 1 << 5,
+    IS_NONZERO      = 1 << 6,
+};
+
+class schema;
+
+// access to variable-length values (std::string, std::vector)
+struct container_ops
+{
+    size_t (*count)(const void *value);
+    void * (*data)(void *value);
+    void   (*resize)(void *value, size_t count);
+};
+
+struct schema_field
+{
+    const char *        name;
+    ptrdiff_t           offset;
+    uint32_t            size;       // size of the field
+    uint32_t            align;
+    uint32_t            count;      // elements in fixed array, 1 for others
+    uint32_t            min_count;
+    uint32_t            item_size;  // size of a scalar or an array element
+    value_kind          kind;
+    value_kind          item_kind;  // kind of array elements, or the same as kind
+    bool                is_signed;
+    uint8_t             flags;      // field_flags
+    const schema *      nested;     // schema of struct (or struct elements)
+    const container_ops *ops;       // for STRING and VECTOR
+    const container_ops *item_ops;  // for STRING elements
+    array_ptr<const enum_option> options;
+
+    // constraints of the value or of every element, see flags
+    int64_t             int_min, int_max;       // HAS_RANGE
+    double              float_min, float_max;   // HAS_RANGE
+    array_ptr<const int64_t> one_of;            // HAS_ONE_OF
+
+    bool is_scalar() const { return kind == value_kind::INT || kind == value_kind::ENUM || kind == value_kind::FLOAT; }
+};
+
+//
+// type descriptions
+//
+
+template<typename T, typename Enable = void>
+struct describe_type
+{
+    static void fill(schema_field& field) {
+        field.kind = value_kind::NONE;
+    }
+};
+
+template<typename T>
+struct describe_type<T, typename std::enable_if<std::is_integral<T>::value>::type>
+{
+    static void fill(schema_field& field) {
+        field.kind = value_kind::INT;
+        field.item_size = sizeof(T);
+        field.is_signed = std::is_signed<T>::value;
+        if (std::is_same<T, bool>::value)
+            field.flags |= IS_BOOL;
+    }
+};
+
+template<typename T>
+struct describe_type<T, typename std::enable_if<std::is_enum<T>::value>::type>
+{
+    static void fill(schema_field& field) {
+        field.kind = value_kind::ENUM;
+        field.item_size = sizeof(T);
+        field.is_signed = std::is_signed<typename std::underlying_type<T>::type>::value;
+        static enum_options<T> x;
+        field.options = array_cast<enum_option>(x);
+    }
+};
+
+template<typename T>
+struct describe_type<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    static void fill(schema_field& field) {
+        field.kind = value_kind::FLOAT;
+        field.item_size = sizeof(T);
+        field.is_signed = true;
+    }
+};
+
+// atomics have the layout of the value
+template<typename T>
+struct describe_type<std::atomic<T>> : describe_type<T>
+{
+};
+
+template<typename T>
+struct describe_type<T, typename std::enable_if<is_struct<T>::value>::type>
+{
+    static void fill(schema_field& field);
+};
+
+template<>
+struct describe_type<std::string>
+{
+    static void fill(schema_field& field);
+};
+
+template<typename E, size_t N>
+struct describe_type<E[N]>
+{
+    static void fill(schema_field& field) {
+        describe_type<E>::fill(field);
+        field.item_kind = field.kind;
+        field.kind = value_kind::ARRAY;
+        field.item_size = sizeof(E);
+        field.item_ops = field.ops;
+        field.ops = nullptr;
+        field.count = N;
+    }
+};
+
+template<typename E, size_t N>
+struct describe_type<std::array<E, N>> : describe_type<E[N]> {};
+
+template<typename E>
+struct describe_type<std::vector<E>>
+{
+    static void fill(schema_field& field) {
+        describe_type<E>::fill(field);
+        field.item_kind = field.kind;
+        field.kind = value_kind::VECTOR;
+        field.item_size = sizeof(E);
+        field.item_ops = field.ops;
+        static const container_ops ops = {
+            [](const void *value) { return static_cast<const std::vector<E> *>(value)->size(); },
+            [](void *value) -> void * { return static_cast<std::vector<E> *>(value)->data(); },
+            [](void *value, size_t count) { static_cast<std::vector<E> *>(value)->resize(count); },
+        };
+        field.ops = &ops;
+    }
+};
+
+//
+// schema_fields: create_field returns `schema_field` of constant size,
+// so struct_fields<Struct, schema_fields> is an array of schema_field
+//
+
+struct schema_fields
+{
+    template<typename Struct>
+    struct base
+    {
+    protected:
+        static constexpr auto raw = (const Struct*)FAKE_RAW_PTR;
+
+        template<typename T, typename... Args>
+        static schema_field create_field(const char* name, const Struct* s, const T* f, const Args&... args)
+        {
+            schema_field field = {};
+            field.name = name;
+            field.offset = ptrdiff_t(f) - ptrdiff_t(s);
+            field.size = sizeof(T);
+            field.align = alignof(T);
+            field.count = 1;
+            field.item_size = sizeof(T);
+            describe_type<T>::fill(field);
+            if (field.item_kind == value_kind::NONE)
+                field.item_kind = field.kind;
+            int dummy[]{ 0, (describe(field, args), 0)... };
+            (void)dummy;
+            return field;
+        }
+
+    private:
+        static void describe(schema_field& field, const with_name& attr) {
+            field.name = attr.get_name();
+        }
+
+        static void describe(schema_field& field, const with_min_count& attr) {
+            field.flags |= HAS_MIN_COUNT;
+            field.min_count = uint32_t(attr.get_min_count());
+        }
+
+        template<typename T>
+        static void describe(schema_field& field, const default_value<T>&) {
+            field.flags |= HAS_DEFAULT;
+        }
+
+        template<typename T>
+        static void describe(schema_field& field, const filler<T>&) {
+            field.flags |= HAS_FILLER;
+        }
+
+        template<typename T>
+        static void describe(schema_field& field, const value_range<T>& attr) {
+            field.flags |= HAS_RANGE;
+            field.int_min = int64_t(attr.get_min());
+            field.int_max = int64_t(attr.get_max());
+            field.float_min = double(attr.get_min());
+            field.float_max = double(attr.get_max());
+        }
+
+        template<typename T, size_t N>
+        static void describe(schema_field& field, const one_of<T, N>& attr) {
+            // schema lives as long as the program
+            auto *values = new int64_t[N];
+            size_t i = 0;
+            for (auto& value : attr.get_values())
+                values[i++] = int64_t(value);
+            field.flags |= HAS_ONE_OF;
+            field.one_of = { values, N };
+        }
+
+        static void describe(schema_field& field, const with_nonzero&) {
+            field.flags |= IS_NONZERO;
+        }
+
+        template<typename Attr>
+        static void describe(schema_field&, const Attr&) {}
+    };
+};
+
+class schema
+{
+public:
+    schema(const schema&) = delete;
+    schema& operator=(const schema&) = delete;
+
+    const char *name() const { return m_name; }
+    size_t size() const { return m_size; }
+    size_t align() const { return m_align; }
+
+    // unique id of the layout, changed with the fields of dynamic schema;
+    // caches are keyed by it, the address may be reused by another schema
+    uint64_t generation() const { return m_generation; }
+
+    size_t count() const { return m_count; }
+    const schema_field *begin() const { return m_fields; }
+    const schema_field *end() const { return m_fields + m_count; }
+    const schema_field& operator[](size_t i) const { return m_fields[i]; }
+
+    // nullptr if not found
+    const schema_field *find(const char *name) const;
+    const schema_field& at(const char *name) const;
+
+    template<typename Struct>
+    static const schema& of();
+
+protected:
+    schema(const char *name, size_t size, size_t align) :
+        m_name(name), m_size(size), m_align(align), m_generation(next_generation()) {}
+
+    void set_fields(const void *fields, size_t size) {
+        m_fields = static_cast<const schema_field *>(fields);
+        m_count = size / sizeof(schema_field);
+        m_generation = next_generation();
+    }
+
+    void set_layout(const char *name, size_t size, size_t align) {
+        m_name = name;
+        m_size = size;
+        m_align = align;
+    }
+
+private:
+    const char *        m_name;
+    size_t              m_size;
+    size_t              m_align;
+    const schema_field *m_fields = nullptr;
+    size_t              m_count = 0;
+    uint64_t            m_generation;
+
+    static uint64_t next_generation();
+};
+
+// a field of the schema flattened to the outer struct
+struct flat_field
+{
+    std::string         path;       // "p.X", "pts[1].X", "a[2]"
+    const schema_field *field;
+    ptrdiff_t           offset;     // from the base of the outer struct
+};
+
+// fields of the schema depth-first in order: nested structs and elements of
+// struct arrays are walked into, other fields are passed to fn; arrays of
+// scalars and strings are passed whole, or element by element if elements
+void for_each_flat(const schema& schema, bool elements, const std::function<void(const flat_field&)>& fn);
+
+template<typename Struct>
+class typed_schema : public schema
+{
+public:
+    typed_schema() : schema(type_name<Struct>(), sizeof(Struct), alignof(Struct)) {
+        set_fields(&m_fields, sizeof(m_fields));
+    }
+
+private:
+    struct_fields<Struct, schema_fields> m_fields;
+};
+
+template<typename Struct>
+const schema& schema::of()
+{
+    static const typed_schema<Struct> instance;
+    return instance;
+}
+
+template<typename T>
+void describe_type<T, typename std::enable_if<is_struct<T>::value>::type>::fill(schema_field& field)
+{
+    field.kind = value_kind::STRUCT;
+    field.nested = &schema::of<T>();
+}
+
+//
+// views: a schema and a base pointer, trivially copyable
+//
+
+class base_view;
+
+// field or array element
+class field_view
+{
+public:
+    field_view(const schema_field& field, void *base) :
+        m_field(&field), m_addr(static_cast<uint8_t *>(base) + field.offset), m_item(false) {}
+
+    const schema_field& field() const { return *m_field; }
+    const char *name() const { return m_field->name; }
+    value_kind kind() const { return m_item ? m_field->item_kind : m_field->kind; }
+    size_t size() const { return m_item ? m_field->item_size : m_field->size; }
+    void *addr() const { return m_addr; }
+
+    // for INT, ENUM and FLOAT
+    int64_t int_value() const;
+    void int_value(int64_t value) const;
+    double float_value() const;
+    void float_value(double value) const;
+
+    // for STRING
+    const char *str_value() const;
+    size_t length() const;
+
+    // for STRUCT
+    base_view nested() const;
+
+    // for ARRAY and VECTOR
+    size_t count() const;
+    field_view item(size_t i) const;
+
+private:
+    field_view(const schema_field *field, uint8_t *addr, bool item) :
+        m_field(field), m_addr(addr), m_item(item) {}
+
+    const container_ops *ops() const { return m_item ? m_field->item_ops : m_field->ops; }
+
+    const schema_field *m_field;
+    uint8_t *           m_addr;
+    bool                m_item;
+};
+
+class base_view
+{
+public:
+    base_view(const schema& schema, void *base) :
+        m_schema(&schema), m_base(base) {}
+
+    const schema& get_schema() const { return *m_schema; }
+    void *addr() const { return m_base; }
+    void addr(void *base) { m_base = base; }
+
+    size_t count() const { return m_schema->count(); }
+    field_view operator[](size_t i) const { return{ (*m_schema)[i], m_base }; }
+    field_view operator[](const char *name) const { return at(name); }
+    field_view at(const char *name) const { return{ m_schema->at(name), m_base }; }
+
+    // resolve dotted path of nested fields, like "p.X"
+    field_view at_path(const char *path) const;
+
+    struct iterator
+    {
+        field_view operator*() const { return{ *field, base }; }
+        iterator& operator++() { ++field; return *this; }
+        bool operator==(const iterator& that) const { return field == that.field; }
+        bool operator!=(const iterator& that) const { return field != that.field; }
+
+        const schema_field *field;
+        void *base;
+    };
+
+    iterator begin() const { return{ m_schema->begin(), m_base }; }
+    iterator end() const { return{ m_schema->end(), m_base }; }
+
+protected:
+    const schema *  m_schema;
+    void *          m_base;
+};
+
+template<typename Struct>
+class struct_view : public base_view
+{
+public:
+    explicit struct_view(Struct& value) :
+        base_view(schema::of<Struct>(), &value) {}
+
+    Struct& get() const { return *static_cast<Struct *>(m_base); }
+    void addr(Struct *value) { m_base = value; }
+};
+
+template<typename Struct>
+struct_view<Struct> view_of(Struct& value)
+{
+    return struct_view<Struct>(value);
+}
+
+// prints in the same format as print_visitor
+std::ostream& operator<<(std::ostream& out, const base_view& view);
+
+INTROSPECT_NS_CLOSE;
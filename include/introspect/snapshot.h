@@ -0,0 +1,72 @@
+#pragma once
+
+#include "schema.h"
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+//
+// snapshot log: append-only binary log of records of one schema,
+// each record keeps only the fields changed since the previous one:
+// a bitmap of the changed fields, then integers as zigzag varint deltas,
+// floats as XOR of their IEEE bits, strings as they are;
+// every keyframe_interval-th record is a keyframe with all the fields,
+// so any record is restored from the nearest keyframe before it;
+// the header keeps a fingerprint of the names, kinds and sizes of the fields,
+// the reader throws parse_error for a log of another schema
+//
+
+using snapshot_field = flat_field;
+
+// scalars and strings, array elements included, in order of the schema
+std::vector<snapshot_field> snapshot_fields(const schema& schema);
+
+class snapshot_writer
+{
+public:
+    snapshot_writer(const schema& schema, std::ostream& out, size_t keyframe_interval = 64);
+
+    // append the record, written to the stream at once
+    void write(const void *record);
+
+    size_t count() const { return m_count; }
+
+private:
+    const schema *  m_schema;
+    std::ostream *  m_out;
+    size_t          m_interval;
+    size_t          m_count = 0;
+
+    std::vector<snapshot_field> m_fields;
+    std::vector<uint64_t>       m_values;   // the previous record
+    std::vector<std::string>    m_strings;
+    std::string                 m_body;
+};
+
+class snapshot_reader
+{
+public:
+    // the log in memory, like a mapped file, the memory should outlive the reader
+    snapshot_reader(const schema& schema, const void *data, size_t size);
+
+    size_t count() const { return m_records.size(); }
+    bool is_keyframe(size_t i) const;
+
+    // restore record i into the value
+    void read(size_t i, void *record) const;
+
+private:
+    void apply(const uint8_t *pos, void *record) const;
+
+    const schema *  m_schema;
+    const uint8_t * m_data;
+    size_t          m_size;
+
+    std::vector<snapshot_field> m_fields;
+    std::vector<size_t>         m_records;  // offsets of the records
+    std::vector<size_t>         m_keyframes;
+};
+
+INTROSPECT_NS_CLOSE;
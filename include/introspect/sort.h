@@ -0,0 +1,38 @@
+#pragma once
+
+#include "path.h"
+#include <utility>
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+//
+// sorting records by fields picked at runtime: the path is compiled once,
+// a single INT, ENUM or FLOAT key is sorted by LSD radix sort
+// (floats by their IEEE bits, ordered as unsigned integers),
+// composite keys "p.X, p.Y" are sorted by comparison;
+// the sort is stable, records with equal keys keep their order
+//
+
+// positions of the records in the sorted order
+std::vector<size_t> sort_index(const schema& schema,
+    const void *records, size_t count, size_t stride, const char *path);
+
+template<typename Struct>
+std::vector<size_t> sort_index(const std::vector<Struct>& records, const char *path)
+{
+    return sort_index(schema::of<Struct>(), records.data(), records.size(), sizeof(Struct), path);
+}
+
+template<typename Struct>
+void sort_by(std::vector<Struct>& records, const char *path)
+{
+    auto index = sort_index(records, path);
+    std::vector<Struct> sorted;
+    sorted.reserve(records.size());
+    for (size_t i : index)
+        sorted.push_back(std::move(records[i]));
+    records.swap(sorted);
+}
+
+INTROSPECT_NS_CLOSE;
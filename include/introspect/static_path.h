@@ -0,0 +1,367 @@
+#pragma once
+
+#include "attrib.h"
+
+#if __cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+
+#define INTROSPECT_HAS_STATIC_PATH 1
+
+#include <string_view>
+#include <tuple>
+
+INTROSPECT_NS_OPEN;
+
+//
+// static_fields: create_field is constexpr and returns
+// the field name (with_name applied) and the address of the field
+// in a never constructed instance, so struct_fields<Struct, static_fields>
+// is a constant, and paths are resolved at compile time:
+//
+//   introspect::get<"p.X">(settings) = 10;
+//
+// structs of up to INTROSPECT_MAX_STATIC_FIELDS (64) fields are supported
+//
+
+template<typename Struct>
+union static_storage
+{
+    constexpr static_storage() : none() {}
+    ~static_storage() {}
+
+    char    none;
+    Struct  value;
+};
+
+template<typename Struct>
+inline static_storage<Struct> static_instance;
+
+template<typename T>
+struct static_field
+{
+    const char *name;
+    const T *   addr;   // in static_instance<Struct>
+};
+
+struct static_fields
+{
+    template<typename Struct>
+    struct base
+    {
+    protected:
+        static constexpr auto raw = (const Struct*)&static_instance<Struct>.value;
+
+        template<typename T, typename... Args>
+        static constexpr static_field<T> create_field(const char* name, const Struct* s, const T* f, const Args&... args)
+        {
+            return{ field_name(name, args...), f };
+        }
+
+    private:
+        static constexpr const char* field_name(const char* name) { return name; }
+
+        template<typename Attr, typename... Args>
+        static constexpr const char* field_name(const char* name, const Attr& attr, const Args&... args)
+        {
+            if constexpr (std::is_same<Attr, with_name>::value)
+                return attr.get_name();
+            else
+                return field_name(name, args...);
+        }
+    };
+};
+
+template<typename Struct>
+inline constexpr struct_fields<Struct, static_fields> static_fields_of{};
+
+//
+// fields of static_fields_of as a tuple, by structured binding;
+// a binding names every field, so the lists are generated by macros
+// up to INTROSPECT_MAX_STATIC_FIELDS fields in a struct
+//
+
+#define INTROSPECT_MAX_STATIC_FIELDS 64
+
+template<size_t N>
+struct tie_fields;
+
+#define INTROSPECT_TIE_FIELDS(N, ...) \
+    template<> struct tie_fields<N> { \
+        template<typename T> static constexpr auto apply(const T& value) { \
+            const auto& [__VA_ARGS__] = value; \
+            return std::make_tuple(__VA_ARGS__); \
+        } \
+    };
+
+#define INTROSPECT_FIELDS_1 f0
+#define INTROSPECT_FIELDS_2 INTROSPECT_FIELDS_1, f1
+#define INTROSPECT_FIELDS_3 INTROSPECT_FIELDS_2, f2
+#define INTROSPECT_FIELDS_4 INTROSPECT_FIELDS_3, f3
+#define INTROSPECT_FIELDS_5 INTROSPECT_FIELDS_4, f4
+#define INTROSPECT_FIELDS_6 INTROSPECT_FIELDS_5, f5
+#define INTROSPECT_FIELDS_7 INTROSPECT_FIELDS_6, f6
+#define INTROSPECT_FIELDS_8 INTROSPECT_FIELDS_7, f7
+#define INTROSPECT_FIELDS_9 INTROSPECT_FIELDS_8, f8
+#define INTROSPECT_FIELDS_10 INTROSPECT_FIELDS_9, f9
+#define INTROSPECT_FIELDS_11 INTROSPECT_FIELDS_10, f10
+#define INTROSPECT_FIELDS_12 INTROSPECT_FIELDS_11, f11
+#define INTROSPECT_FIELDS_13 INTROSPECT_FIELDS_12, f12
+#define INTROSPECT_FIELDS_14 INTROSPECT_FIELDS_13, f13
+#define INTROSPECT_FIELDS_15 INTROSPECT_FIELDS_14, f14
+#define INTROSPECT_FIELDS_16 INTROSPECT_FIELDS_15, f15
+#define INTROSPECT_FIELDS_17 INTROSPECT_FIELDS_16, f16
+#define INTROSPECT_FIELDS_18 INTROSPECT_FIELDS_17, f17
+#define INTROSPECT_FIELDS_19 INTROSPECT_FIELDS_18, f18
+#define INTROSPECT_FIELDS_20 INTROSPECT_FIELDS_19, f19
+#define INTROSPECT_FIELDS_21 INTROSPECT_FIELDS_20, f20
+#define INTROSPECT_FIELDS_22 INTROSPECT_FIELDS_21, f21
+#define INTROSPECT_FIELDS_23 INTROSPECT_FIELDS_22, f22
+#define INTROSPECT_FIELDS_24 INTROSPECT_FIELDS_23, f23
+#define INTROSPECT_FIELDS_25 INTROSPECT_FIELDS_24, f24
+#define INTROSPECT_FIELDS_26 INTROSPECT_FIELDS_25, f25
+#define INTROSPECT_FIELDS_27 INTROSPECT_FIELDS_26, f26
+#define INTROSPECT_FIELDS_28 INTROSPECT_FIELDS_27, f27
+#define INTROSPECT_FIELDS_29 INTROSPECT_FIELDS_28, f28
+#define INTROSPECT_FIELDS_30 INTROSPECT_FIELDS_29, f29
+#define INTROSPECT_FIELDS_31 INTROSPECT_FIELDS_30, f30
+#define INTROSPECT_FIELDS_32 INTROSPECT_FIELDS_31, f31
+#define INTROSPECT_FIELDS_33 INTROSPECT_FIELDS_32, f32
+#define INTROSPECT_FIELDS_34 INTROSPECT_FIELDS_33, f33
+#define INTROSPECT_FIELDS_35 INTROSPECT_FIELDS_34, f34
+#define INTROSPECT_FIELDS_36 INTROSPECT_FIELDS_35, f35
+#define INTROSPECT_FIELDS_37 INTROSPECT_FIELDS_36, f36
+#define INTROSPECT_FIELDS_38 INTROSPECT_FIELDS_37, f37
+#define INTROSPECT_FIELDS_39 INTROSPECT_FIELDS_38, f38
+#define INTROSPECT_FIELDS_40 INTROSPECT_FIELDS_39, f39
+#define INTROSPECT_FIELDS_41 INTROSPECT_FIELDS_40, f40
+#define INTROSPECT_FIELDS_42 INTROSPECT_FIELDS_41, f41
+#define INTROSPECT_FIELDS_43 INTROSPECT_FIELDS_42, f42
+#define INTROSPECT_FIELDS_44 INTROSPECT_FIELDS_43, f43
+#define INTROSPECT_FIELDS_45 INTROSPECT_FIELDS_44, f44
+#define INTROSPECT_FIELDS_46 INTROSPECT_FIELDS_45, f45
+#define INTROSPECT_FIELDS_47 INTROSPECT_FIELDS_46, f46
+#define INTROSPECT_FIELDS_48 INTROSPECT_FIELDS_47, f47
+#define INTROSPECT_FIELDS_49 INTROSPECT_FIELDS_48, f48
+#define INTROSPECT_FIELDS_50 INTROSPECT_FIELDS_49, f49
+#define INTROSPECT_FIELDS_51 INTROSPECT_FIELDS_50, f50
+#define INTROSPECT_FIELDS_52 INTROSPECT_FIELDS_51, f51
+#define INTROSPECT_FIELDS_53 INTROSPECT_FIELDS_52, f52
+#define INTROSPECT_FIELDS_54 INTROSPECT_FIELDS_53, f53
+#define INTROSPECT_FIELDS_55 INTROSPECT_FIELDS_54, f54
+#define INTROSPECT_FIELDS_56 INTROSPECT_FIELDS_55, f55
+#define INTROSPECT_FIELDS_57 INTROSPECT_FIELDS_56, f56
+#define INTROSPECT_FIELDS_58 INTROSPECT_FIELDS_57, f57
+#define INTROSPECT_FIELDS_59 INTROSPECT_FIELDS_58, f58
+#define INTROSPECT_FIELDS_60 INTROSPECT_FIELDS_59, f59
+#define INTROSPECT_FIELDS_61 INTROSPECT_FIELDS_60, f60
+#define INTROSPECT_FIELDS_62 INTROSPECT_FIELDS_61, f61
+#define INTROSPECT_FIELDS_63 INTROSPECT_FIELDS_62, f62
+#define INTROSPECT_FIELDS_64 INTROSPECT_FIELDS_63, f63
+
+INTROSPECT_TIE_FIELDS(1, INTROSPECT_FIELDS_1)
+INTROSPECT_TIE_FIELDS(2, INTROSPECT_FIELDS_2)
+INTROSPECT_TIE_FIELDS(3, INTROSPECT_FIELDS_3)
+INTROSPECT_TIE_FIELDS(4, INTROSPECT_FIELDS_4)
+INTROSPECT_TIE_FIELDS(5, INTROSPECT_FIELDS_5)
+INTROSPECT_TIE_FIELDS(6, INTROSPECT_FIELDS_6)
+INTROSPECT_TIE_FIELDS(7, INTROSPECT_FIELDS_7)
+INTROSPECT_TIE_FIELDS(8, INTROSPECT_FIELDS_8)
+INTROSPECT_TIE_FIELDS(9, INTROSPECT_FIELDS_9)
+INTROSPECT_TIE_FIELDS(10, INTROSPECT_FIELDS_10)
+INTROSPECT_TIE_FIELDS(11, INTROSPECT_FIELDS_11)
+INTROSPECT_TIE_FIELDS(12, INTROSPECT_FIELDS_12)
+INTROSPECT_TIE_FIELDS(13, INTROSPECT_FIELDS_13)
+INTROSPECT_TIE_FIELDS(14, INTROSPECT_FIELDS_14)
+INTROSPECT_TIE_FIELDS(15, INTROSPECT_FIELDS_15)
+INTROSPECT_TIE_FIELDS(16, INTROSPECT_FIELDS_16)
+INTROSPECT_TIE_FIELDS(17, INTROSPECT_FIELDS_17)
+INTROSPECT_TIE_FIELDS(18, INTROSPECT_FIELDS_18)
+INTROSPECT_TIE_FIELDS(19, INTROSPECT_FIELDS_19)
+INTROSPECT_TIE_FIELDS(20, INTROSPECT_FIELDS_20)
+INTROSPECT_TIE_FIELDS(21, INTROSPECT_FIELDS_21)
+INTROSPECT_TIE_FIELDS(22, INTROSPECT_FIELDS_22)
+INTROSPECT_TIE_FIELDS(23, INTROSPECT_FIELDS_23)
+INTROSPECT_TIE_FIELDS(24, INTROSPECT_FIELDS_24)
+INTROSPECT_TIE_FIELDS(25, INTROSPECT_FIELDS_25)
+INTROSPECT_TIE_FIELDS(26, INTROSPECT_FIELDS_26)
+INTROSPECT_TIE_FIELDS(27, INTROSPECT_FIELDS_27)
+INTROSPECT_TIE_FIELDS(28, INTROSPECT_FIELDS_28)
+INTROSPECT_TIE_FIELDS(29, INTROSPECT_FIELDS_29)
+INTROSPECT_TIE_FIELDS(30, INTROSPECT_FIELDS_30)
+INTROSPECT_TIE_FIELDS(31, INTROSPECT_FIELDS_31)
+INTROSPECT_TIE_FIELDS(32, INTROSPECT_FIELDS_32)
+INTROSPECT_TIE_FIELDS(33, INTROSPECT_FIELDS_33)
+INTROSPECT_TIE_FIELDS(34, INTROSPECT_FIELDS_34)
+INTROSPECT_TIE_FIELDS(35, INTROSPECT_FIELDS_35)
+INTROSPECT_TIE_FIELDS(36, INTROSPECT_FIELDS_36)
+INTROSPECT_TIE_FIELDS(37, INTROSPECT_FIELDS_37)
+INTROSPECT_TIE_FIELDS(38, INTROSPECT_FIELDS_38)
+INTROSPECT_TIE_FIELDS(39, INTROSPECT_FIELDS_39)
+INTROSPECT_TIE_FIELDS(40, INTROSPECT_FIELDS_40)
+INTROSPECT_TIE_FIELDS(41, INTROSPECT_FIELDS_41)
+INTROSPECT_TIE_FIELDS(42, INTROSPECT_FIELDS_42)
+INTROSPECT_TIE_FIELDS(43, INTROSPECT_FIELDS_43)
+INTROSPECT_TIE_FIELDS(44, INTROSPECT_FIELDS_44)
+INTROSPECT_TIE_FIELDS(45, INTROSPECT_FIELDS_45)
+INTROSPECT_TIE_FIELDS(46, INTROSPECT_FIELDS_46)
+INTROSPECT_TIE_FIELDS(47, INTROSPECT_FIELDS_47)
+INTROSPECT_TIE_FIELDS(48, INTROSPECT_FIELDS_48)
+INTROSPECT_TIE_FIELDS(49, INTROSPECT_FIELDS_49)
+INTROSPECT_TIE_FIELDS(50, INTROSPECT_FIELDS_50)
+INTROSPECT_TIE_FIELDS(51, INTROSPECT_FIELDS_51)
+INTROSPECT_TIE_FIELDS(52, INTROSPECT_FIELDS_52)
+INTROSPECT_TIE_FIELDS(53, INTROSPECT_FIELDS_53)
+INTROSPECT_TIE_FIELDS(54, INTROSPECT_FIELDS_54)
+INTROSPECT_TIE_FIELDS(55, INTROSPECT_FIELDS_55)
+INTROSPECT_TIE_FIELDS(56, INTROSPECT_FIELDS_56)
+INTROSPECT_TIE_FIELDS(57, INTROSPECT_FIELDS_57)
+INTROSPECT_TIE_FIELDS(58, INTROSPECT_FIELDS_58)
+INTROSPECT_TIE_FIELDS(59, INTROSPECT_FIELDS_59)
+INTROSPECT_TIE_FIELDS(60, INTROSPECT_FIELDS_60)
+INTROSPECT_TIE_FIELDS(61, INTROSPECT_FIELDS_61)
+INTROSPECT_TIE_FIELDS(62, INTROSPECT_FIELDS_62)
+INTROSPECT_TIE_FIELDS(63, INTROSPECT_FIELDS_63)
+INTROSPECT_TIE_FIELDS(64, INTROSPECT_FIELDS_64)
+
+#undef INTROSPECT_TIE_FIELDS
+#undef INTROSPECT_FIELDS_1
+#undef INTROSPECT_FIELDS_2
+#undef INTROSPECT_FIELDS_3
+#undef INTROSPECT_FIELDS_4
+#undef INTROSPECT_FIELDS_5
+#undef INTROSPECT_FIELDS_6
+#undef INTROSPECT_FIELDS_7
+#undef INTROSPECT_FIELDS_8
+#undef INTROSPECT_FIELDS_9
+#undef INTROSPECT_FIELDS_10
+#undef INTROSPECT_FIELDS_11
+#undef INTROSPECT_FIELDS_12
+#undef INTROSPECT_FIELDS_13
+#undef INTROSPECT_FIELDS_14
+#undef INTROSPECT_FIELDS_15
+#undef INTROSPECT_FIELDS_16
+#undef INTROSPECT_FIELDS_17
+#undef INTROSPECT_FIELDS_18
+#undef INTROSPECT_FIELDS_19
+#undef INTROSPECT_FIELDS_20
+#undef INTROSPECT_FIELDS_21
+#undef INTROSPECT_FIELDS_22
+#undef INTROSPECT_FIELDS_23
+#undef INTROSPECT_FIELDS_24
+#undef INTROSPECT_FIELDS_25
+#undef INTROSPECT_FIELDS_26
+#undef INTROSPECT_FIELDS_27
+#undef INTROSPECT_FIELDS_28
+#undef INTROSPECT_FIELDS_29
+#undef INTROSPECT_FIELDS_30
+#undef INTROSPECT_FIELDS_31
+#undef INTROSPECT_FIELDS_32
+#undef INTROSPECT_FIELDS_33
+#undef INTROSPECT_FIELDS_34
+#undef INTROSPECT_FIELDS_35
+#undef INTROSPECT_FIELDS_36
+#undef INTROSPECT_FIELDS_37
+#undef INTROSPECT_FIELDS_38
+#undef INTROSPECT_FIELDS_39
+#undef INTROSPECT_FIELDS_40
+#undef INTROSPECT_FIELDS_41
+#undef INTROSPECT_FIELDS_42
+#undef INTROSPECT_FIELDS_43
+#undef INTROSPECT_FIELDS_44
+#undef INTROSPECT_FIELDS_45
+#undef INTROSPECT_FIELDS_46
+#undef INTROSPECT_FIELDS_47
+#undef INTROSPECT_FIELDS_48
+#undef INTROSPECT_FIELDS_49
+#undef INTROSPECT_FIELDS_50
+#undef INTROSPECT_FIELDS_51
+#undef INTROSPECT_FIELDS_52
+#undef INTROSPECT_FIELDS_53
+#undef INTROSPECT_FIELDS_54
+#undef INTROSPECT_FIELDS_55
+#undef INTROSPECT_FIELDS_56
+#undef INTROSPECT_FIELDS_57
+#undef INTROSPECT_FIELDS_58
+#undef INTROSPECT_FIELDS_59
+#undef INTROSPECT_FIELDS_60
+#undef INTROSPECT_FIELDS_61
+#undef INTROSPECT_FIELDS_62
+#undef INTROSPECT_FIELDS_63
+#undef INTROSPECT_FIELDS_64
+
+template<typename Struct>
+constexpr auto static_field_tuple()
+{
+    constexpr size_t count = sizeof(static_fields_of<Struct>) / sizeof(static_field<char>);
+    static_assert(count <= INTROSPECT_MAX_STATIC_FIELDS, "too many fields for static paths, see INTROSPECT_MAX_STATIC_FIELDS");
+    return tie_fields<count>::apply(static_fields_of<Struct>);
+}
+
+constexpr size_t STATIC_NPOS = size_t(-1);
+
+template<typename Tuple, size_t... I>
+constexpr size_t find_static_field(const Tuple& fields, std::string_view name, std::index_sequence<I...>)
+{
+    size_t index = STATIC_NPOS;
+    ((index = (index == STATIC_NPOS && name == std::get<I>(fields).name) ? I : index), ...);
+    return index;
+}
+
+// the member of the value described by the static field
+template<typename Struct, typename T>
+auto& static_member(Struct& value, const static_field<T>& field)
+{
+    // difference of two constant addresses, folded by the compiler
+    using type = typename std::remove_const<Struct>::type;
+    using result_type = typename std::conditional<std::is_const<Struct>::value, const T, T>::type;
+    auto offset = reinterpret_cast<const char *>(field.addr) - reinterpret_cast<const char *>(&static_instance<type>.value);
+    auto *base = const_cast<char *>(reinterpret_cast<const char *>(&value));
+    return *reinterpret_cast<result_type *>(base + offset);
+}
+
+//
+// fixed_string: string literal as template parameter
+//
+
+template<size_t N>
+struct fixed_string
+{
+    constexpr fixed_string(const char (&str)[N]) {
+        for (size_t i = 0; i < N; i++)
+            value[i] = str[i];
+    }
+
+    constexpr std::string_view view() const { return { value, N - 1 }; }
+
+    char value[N];
+};
+
+// resolve the segment of the path starting at Pos in Struct
+template<fixed_string Path, size_t Pos, typename Struct>
+auto& get_static(Struct& value)
+{
+    using type = typename std::remove_const<Struct>::type;
+    constexpr auto fields = static_field_tuple<type>();
+    constexpr auto path = Path.view();
+    constexpr size_t dot = path.find('.', Pos);
+    constexpr auto name = path.substr(Pos, dot == path.npos ? path.npos : dot - Pos);
+    constexpr size_t index = find_static_field(fields, name,
+        std::make_index_sequence<std::tuple_size<decltype(fields)>::value>());
+    static_assert(index != STATIC_NPOS, "unknown field in path");
+
+    auto& result = static_member(value, std::get<index == STATIC_NPOS ? 0 : index>(fields));
+
+    if constexpr (dot == path.npos)
+        return result;
+    else
+        return get_static<Path, dot + 1>(result);
+}
+
+template<fixed_string Path, typename Struct>
+auto& get(Struct& value)
+{
+    return get_static<Path, 0>(value);
+}
+
+INTROSPECT_NS_CLOSE;
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "fields.h"
+#include "parallel.h"
+#include <functional>
+#include <memory>
+
+INTROSPECT_NS_OPEN;
+
+//
+// parallel_visit: read-only traversal of a large struct on parallel_run;
+// nested structs are split into their fields, consecutive fields of a struct
+// make one task, arrays longer than ELEMENTS_PER_TASK are split into ranges
+// of elements; every worker has its own mirror of the value,
+// so mirrors aren't shared between the threads
+//
+
+static constexpr size_t ELEMENTS_PER_TASK = 256;
+
+// the visitor is forked for each task, the parts are joined into it
+// in order of the tasks, so the result doesn't depend on the threads
+struct parallel_visitor : const_visitor
+{
+    virtual ~parallel_visitor() {}
+
+    virtual std::unique_ptr<parallel_visitor> fork() const = 0;
+    virtual void join(parallel_visitor& part) = 0;
+
+    // the field, "p.X" for nested ones
+    virtual void visit_field(const char *path, const base_mirror& value) { value.visit(*this); }
+
+    // element i of the array field, when the array is split
+    virtual void visit_element(const char *path, size_t i, const base_mirror& value) { value.visit(*this); }
+};
+
+// mirror of the value for one worker
+using mirror_factory = std::function<std::unique_ptr<struct_mirror>()>;
+
+void parallel_visit(const mirror_factory& factory, parallel_visitor& v, size_t threads = 0);
+
+template<typename Struct, typename Fields = simple_fields>
+void parallel_visit(const Struct& value, parallel_visitor& v, size_t threads = 0)
+{
+    auto *raw = const_cast<Struct *>(&value);
+    parallel_visit(mirror_factory([raw] {
+        std::unique_ptr<struct_mirror> mirror(new introspect::mirror<Struct, Fields>());
+        mirror->addr(raw);
+        return mirror;
+    }), v, threads);
+}
+
+INTROSPECT_NS_CLOSE;
@@ -11,7 +11,10 @@ class array_ptr
     size_t  m_size;
 public:
 
-    array_ptr(E *base, size_t *size) :
+    array_ptr() :
+        m_base(nullptr), m_size(0) {}
+
+    array_ptr(E *base, size_t size) :
         m_base(base), m_size(size) {}
 
     template<size_t N>
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "schema.h"
+#include <string>
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+//
+// validator: constraints of a schema (with_range, with_one_of, with_nonzero)
+// compiled once into a flat list of rules, one bit per rule;
+// records are checked rule by rule, so the inner loops
+// are branch-free and can be vectorized by the compiler
+//
+
+struct validation_rule;
+
+using check_fn = void (*)(const validation_rule& rule,
+    const uint8_t *records, size_t count, size_t stride, uint64_t *masks, size_t words);
+
+struct validation_rule
+{
+    check_fn        check;
+    size_t          bit;        // index of the rule
+    ptrdiff_t       offset;     // from the record base
+    uint32_t        count;      // elements of fixed array, 1 for others
+    const container_ops *ops;   // elements of vector
+    int64_t         int_min, int_max;
+    double          float_min, float_max;
+    array_ptr<const int64_t> one_of;
+    std::string     path;
+};
+
+class validator
+{
+public:
+    explicit validator(const schema& schema);
+
+    template<typename Struct>
+    static const validator& of() {
+        static const validator instance(schema::of<Struct>());
+        return instance;
+    }
+
+    const schema& get_schema() const { return *m_schema; }
+
+    size_t count() const { return m_rules.size(); }
+    const validation_rule& operator[](size_t i) const { return m_rules[i]; }
+
+    // 64-bit words of the mask of one record, bit i is set if rule i is violated
+    size_t words() const { return (m_rules.size() + 63) / 64; }
+
+    // check one record, the mask has words() words; true if valid
+    bool check(const void *record, uint64_t *mask) const;
+
+    // check records of the span, masks have count * words() words;
+    // returns the number of invalid records
+    size_t check(const void *records, size_t count, size_t stride, uint64_t *masks) const;
+
+    // paths of the violated fields of one record
+    std::vector<std::string> violations(const void *record) const;
+
+private:
+    void add_rules(const schema_field& field, ptrdiff_t offset, const std::string& path);
+
+    const schema *  m_schema;
+    std::vector<validation_rule> m_rules;
+};
+
+template<typename Struct>
+bool is_valid(const Struct& value)
+{
+    auto& rules = validator::of<Struct>();
+    std::vector<uint64_t> mask(rules.words());
+    return rules.check(&value, mask.data());
+}
+
+template<typename Struct>
+std::vector<std::string> violations(const Struct& value)
+{
+    return validator::of<Struct>().violations(&value);
+}
+
+// masks of contiguous records, see validator::check
+template<typename Struct>
+size_t validate(const Struct *records, size_t count, std::vector<uint64_t>& masks)
+{
+    auto& rules = validator::of<Struct>();
+    masks.resize(count * rules.words());
+    return rules.check(records, count, sizeof(Struct), masks.data());
+}
+
+INTROSPECT_NS_CLOSE;
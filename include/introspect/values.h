@@ -4,8 +4,18 @@
 #include "errors.h"
 #include <type_traits>
 #include <array>
+#include <memory>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstring>
 #include "utils.h"
 
+#if defined(__cpp_rtti) || defined(__GXX_RTTI) || defined(_CPPRTTI)
+#define INTROSPECT_RTTI 1
+#include <typeinfo>
+#endif
+
 INTROSPECT_NS_OPEN;
 
 struct visitor
@@ -15,7 +25,10 @@ struct visitor
     virtual void visit(enum_mirror& value);
     virtual void visit(float_mirror& value);
     virtual void visit(array_mirror& value);
+    virtual void visit(vector_mirror& value);
+    virtual void visit(string_mirror& value);
     virtual void visit(struct_mirror& value);
+    virtual void visit(struct_array_mirror& value);
 };
 
 struct const_visitor
@@ -25,13 +38,57 @@ struct const_visitor
     virtual void visit(const enum_mirror& value);
     virtual void visit(const float_mirror& value);
     virtual void visit(const array_mirror& value);
+    virtual void visit(const vector_mirror& value);
+    virtual void visit(const string_mirror& value);
     virtual void visit(const struct_mirror& value);
+    virtual void visit(const struct_array_mirror& value);
 };
 
 #define VISIT_IMPL \
-    virtual void visit(visitor& v) { v.visit(*this); } \
-    virtual void visit(const_visitor& v) const { v.visit(*this); }
+    virtual void visit(visitor& v) { INTROSPECT_TOUCH(this); v.visit(*this); } \
+    virtual void visit(const_visitor& v) const { INTROSPECT_TOUCH(this); v.visit(*this); }
+
+
+// kind of the mirror interface, for dispatch without RTTI
+enum class mirror_kind : uint8_t
+{
+    OTHER,
+    INT,
+    ENUM,
+    FLOAT,
+    ARRAY,
+    VECTOR,
+    STRING,
+    STRUCT,
+    STRUCT_ARRAY,
+};
+
+// bits of field attributes, see base_mirror::attr_bits
+enum attr_bit : uint32_t
+{
+    ATTR_NAME       = 1 << 0,
+    ATTR_DEFAULT    = 1 << 1,
+    ATTR_FILLER     = 1 << 2,
+    ATTR_MIN_COUNT  = 1 << 3,
+    ATTR_RANGE      = 1 << 4,
+    ATTR_ONE_OF     = 1 << 5,
+    ATTR_NONZERO    = 1 << 6,
+    ATTR_MAPPING    = 1 << 7,
+};
 
+// specialized for attributes: the bit and the type find_attr() returns,
+// void for attributes not found by the bit, like mappings
+template<typename Attr>
+struct attr_traits
+{
+    static const uint32_t bit = 0;
+    using type = Attr;
+};
+
+#define MIRROR_KIND(tag, base) \
+    static const mirror_kind KIND = mirror_kind::tag; \
+    mirror_kind kind() const override { return KIND; } \
+    void *as_kind(mirror_kind kind) override { return kind == KIND ? this : base::as_kind(kind); }
 
 #pragma warning(disable:4250) // virtual inheritance warning
 struct base_mirror
@@ -44,9 +101,126 @@ struct base_mirror
     virtual void addr(void *addr) = 0;
     virtual const char *type() const = 0;
 
+    // follow the base of the root mirror: the value is at *root + offset
+    virtual void link(uint8_t *const *root, ptrdiff_t offset) { addr(*root + offset); }
+
+    // the most derived interface, and the interface of the kind or nullptr;
+    // use mirror_cast instead of dynamic_cast
+    virtual mirror_kind kind() const { return mirror_kind::OTHER; }
+    virtual void *as_kind(mirror_kind kind) { return nullptr; }
+
+    // attributes of the field, and the attribute with the bit or nullptr;
+    // use attr_cast instead of dynamic_cast
+    virtual uint32_t attr_bits() const { return 0; }
+    virtual void *find_attr(uint32_t bit) { return nullptr; }
+
+    // struct_mapping<Struct> of the field by struct_mapping<Struct>::key(),
+    // or nullptr; use mapping_cast
+    virtual void *find_mapping(const void *key) { return nullptr; }
+
+    // called after the value is modified, fields report it to observer and dirty_tracker
+    virtual void mark_changed() {}
+
+    // the field is modified since the marks of dirty_tracker were cleared
+    virtual bool marked() const { return false; }
+
+    // the value or some field of its subtree is marked
+    virtual bool subtree_marked() const;
+
+#ifdef INTROSPECT_PROFILE
+    // called on access to the value, fields count it
+    virtual void touched() const {}
+#endif
+
     VISIT_IMPL
 };
 
+// the value is marked, or some field of the struct
+bool has_marked(const base_mirror& value);
+
+// checked downcast to the interface (int_mirror, struct_mirror, ...)
+template<typename T>
+T *mirror_cast(base_mirror *value) { return static_cast<T *>(value->as_kind(T::KIND)); }
+
+template<typename T>
+const T *mirror_cast(const base_mirror *value) { return mirror_cast<T>(const_cast<base_mirror *>(value)); }
+
+template<typename Attr>
+typename attr_traits<Attr>::type *attr_cast(base_mirror *value) {
+    static_assert(!std::is_void<typename attr_traits<Attr>::type>::value,
+        "iterate fields<struct_mapping<Struct>>() to find mappings");
+    return static_cast<typename attr_traits<Attr>::type *>(value->find_attr(attr_traits<Attr>::bit));
+}
+
+// name of the type, readable one without RTTI
+std::string signature_type(const char *signature);
+
+template<typename T>
+const char *type_name()
+{
+#ifdef INTROSPECT_RTTI
+    return typeid(T).name();
+#else
+#ifdef _MSC_VER
+    static const std::string name = signature_type(__FUNCSIG__);
+#else
+    static const std::string name = signature_type(__PRETTY_FUNCTION__);
+#endif
+    return name.c_str();
+#endif
+}
+
+//
+// value_ptr: pointer to the mirrored value,
+// either own or relative to the base of the root mirror,
+// so rebinding the root moves all linked fields with one store
+//
+
+template<typename T>
+class value_ptr
+{
+public:
+    value_ptr(T *ptr = nullptr) :
+        m_base(reinterpret_cast<uint8_t *>(ptr)) {}
+
+    value_ptr& operator=(T *ptr) {
+        m_base = reinterpret_cast<uint8_t *>(ptr);
+        m_root = nullptr;
+        m_offset = 0;
+        return *this;
+    }
+
+    void link(uint8_t *const *root, ptrdiff_t offset) {
+        m_base = nullptr;
+        m_root = root;
+        m_offset = offset;
+    }
+
+    bool linked() const { return m_root != nullptr; }
+
+    // base and offset for nested values to link to
+    uint8_t *const *root() const { return m_root ? m_root : &m_base; }
+    ptrdiff_t offset() const { return m_root ? m_offset : 0; }
+
+    T *get() const { return reinterpret_cast<T *>(m_root ? *m_root + m_offset : m_base); }
+    operator T *() const { return get(); }
+    T& operator*() const { return *get(); }
+    T *operator->() const { return get(); }
+    T& operator[](size_t i) const { return get()[i]; }
+
+private:
+    uint8_t *       m_base;
+    uint8_t *const *m_root = nullptr;
+    ptrdiff_t       m_offset = 0;
+};
+
+// false if assignment of b to a doesn't change a
+template<typename T>
+auto differs(const T& a, const T& b, int) -> decltype(bool(a != b)) { return a != b; }
+
+template<typename T>
+bool differs(const T&, const T&, ...) { return true; }
+
 template<typename T, typename Base>
 struct typed_mirror : Base
 {
@@ -57,14 +231,23 @@ struct typed_mirror : Base
     size_t size() const override { return sizeof(T); }
     void *addr() override { return raw; }
     void addr(void *addr) override { raw = reinterpret_cast<T *>(addr); }
-    const char *type() const override { return typeid(T).name(); }
+    void link(uint8_t *const *root, ptrdiff_t offset) override { raw.link(root, offset); }
+    const char *type() const override { return type_name<T>(); }
+
+    T& get() { INTROSPECT_TOUCH(this); return *this->raw; }
+    const T& get() const { INTROSPECT_TOUCH(this); return *this->raw; }
+    void set(const T& value) {
+        INTROSPECT_TOUCH(this);
+        if (differs(*raw, value, 0)) {
+            *raw = value;
+            this->mark_changed();
+        }
+    }
 
-    T& get() { return *raw; }
-    const T& get() const { return *raw; }
-    void set(const T& value) { *raw = value; }
+    const value_ptr<T>& raw_ptr() const { return raw; }
 
 protected:
-    T *raw = nullptr;
+    value_ptr<T> raw;
 };
 
 //
@@ -74,6 +257,7 @@ protected:
 struct int_mirror : virtual base_mirror
 {
     VISIT_IMPL;
+    MIRROR_KIND(INT, base_mirror);
 
     virtual int64_t int_value() const = 0;
     virtual void int_value(int64_t value) = 0;
@@ -87,13 +271,14 @@ struct mirror<T, typename std::enable_if<std::is_integral<T>::value>::type> :
     mirror(const mirror& that) = default;
     explicit mirror(T& raw) : typed_mirror(raw) {}
 
-    int64_t int_value() const override { return *raw; }
-    void int_value(int64_t value) override { *raw = static_cast<T>(value); }
+    int64_t int_value() const override { INTROSPECT_TOUCH(this); return *this->raw; }
+    void int_value(int64_t value) override { this->set(static_cast<T>(value)); }
 };
 
 struct float_mirror : virtual base_mirror
 {
     VISIT_IMPL;
+    MIRROR_KIND(FLOAT, base_mirror);
 
     virtual double float_value() const = 0;
     virtual void float_value(double value) = 0;
@@ -107,8 +292,49 @@ struct mirror<T, typename std::enable_if<std::is_floating_point<T>::value>::type
     mirror(const mirror& that) = default;
     explicit mirror(T& raw) : typed_mirror(raw) {}
 
-    double float_value() const override { return *raw; }
-    void float_value(double value) override { *raw = static_cast<T>(value); }
+    double float_value() const override { INTROSPECT_TOUCH(this); return *this->raw; }
+    void float_value(double value) override { this->set(static_cast<T>(value)); }
+};
+
+// atomic counters, accessed with relaxed ordering
+
+template<typename T, typename Base>
+struct typed_atomic : typed_mirror<std::atomic<T>, Base>
+{
+    typed_atomic() = default;
+    typed_atomic(const typed_atomic& that) = default;
+    explicit typed_atomic(std::atomic<T>& raw) : typed_mirror<std::atomic<T>, Base>(raw) {}
+
+    T get() const { INTROSPECT_TOUCH(this); return this->raw->load(std::memory_order_relaxed); }
+    void set(const T& value) {
+        INTROSPECT_TOUCH(this);
+        if (this->raw->exchange(value, std::memory_order_relaxed) != value)
+            this->mark_changed();
+    }
+};
+
+template<typename T>
+struct mirror<std::atomic<T>, typename std::enable_if<std::is_integral<T>::value>::type> :
+    typed_atomic<T, int_mirror>
+{
+    mirror() = default;
+    mirror(const mirror& that) = default;
+    explicit mirror(std::atomic<T>& raw) : typed_atomic<T, int_mirror>(raw) {}
+
+    int64_t int_value() const override { return this->get(); }
+    void int_value(int64_t value) override { this->set(static_cast<T>(value)); }
+};
+
+template<typename T>
+struct mirror<std::atomic<T>, typename std::enable_if<std::is_floating_point<T>::value>::type> :
+    typed_atomic<T, float_mirror>
+{
+    mirror() = default;
+    mirror(const mirror& that) = default;
+    explicit mirror(std::atomic<T>& raw) : typed_atomic<T, float_mirror>(raw) {}
+
+    double float_value() const override { return this->get(); }
+    void float_value(double value) override { this->set(static_cast<T>(value)); }
 };
 
 // support enumerations
@@ -132,6 +358,7 @@ struct enum_options
 struct enum_mirror : int_mirror
 {
     VISIT_IMPL;
+    MIRROR_KIND(ENUM, int_mirror);
 
     virtual array_ptr<const enum_option> options() const = 0;
 };
@@ -143,8 +370,8 @@ struct typed_enum : typed_mirror<T, enum_mirror>
     typed_enum(const typed_enum& that) = default;
     explicit typed_enum(T& raw) : typed_mirror(raw) {}
 
-    int64_t int_value() const override { return *raw; }
-    void int_value(int64_t value) override { *raw = static_cast<T>(value); }
+    int64_t int_value() const override { INTROSPECT_TOUCH(this); return *this->raw; }
+    void int_value(int64_t value) override { this->set(static_cast<T>(value)); }
 
     array_ptr<const enum_option> options() const override {
         static enum_options<T> x;
@@ -160,6 +387,37 @@ struct mirror<T, typename std::enable_if<std::is_enum<T>::value>::type>: typed_e
     explicit mirror(T& raw) : typed_enum(raw) {}
 };
 
+// strings
+
+struct string_mirror : virtual base_mirror
+{
+    VISIT_IMPL;
+    MIRROR_KIND(STRING, base_mirror);
+
+    virtual const char *str_value() const = 0;
+    virtual size_t length() const = 0;
+    // assign keeps the capacity, short strings stay in place
+    virtual void str_value(const char *value, size_t length) = 0;
+    void str_value(const char *value) { str_value(value, strlen(value)); }
+};
+
+template<>
+struct mirror<std::string> : typed_mirror<std::string, string_mirror>
+{
+    mirror() = default;
+    mirror(const mirror& that) = default;
+    explicit mirror(std::string& raw) : typed_mirror<std::string, string_mirror>(raw) {}
+
+    const char *str_value() const override { INTROSPECT_TOUCH(this); return raw->c_str(); }
+    size_t length() const override { return raw->size(); }
+    void str_value(const char *value, size_t length) override {
+        if (raw->compare(0, raw->npos, value, length) != 0) {
+            raw->assign(value, length);
+            mark_changed();
+        }
+    }
+    using string_mirror::str_value;
+};
 
 // value pointers
 
@@ -183,7 +441,15 @@ public:
     size_t size() const override { return value->size(); }
     void * addr() override { return value->addr(); }
     void addr(void *addr) override { value->addr(addr); }
+    void link(uint8_t *const *root, ptrdiff_t offset) override { value->link(root, offset); }
     const char *type() const override { return value->type(); }
+    mirror_kind kind() const override { return value->kind(); }
+    void *as_kind(mirror_kind kind) override { return value->as_kind(kind); }
+    uint32_t attr_bits() const override { return value->attr_bits(); }
+    void *find_attr(uint32_t bit) override { return value->find_attr(bit); }
+    void *find_mapping(const void *key) override { return value->find_mapping(key); }
+    bool marked() const override { return value->marked(); }
+    bool subtree_marked() const override { return value->subtree_marked(); }
 
     void visit(visitor& v) override { value->visit(v); }
     void visit(const_visitor& v) const override { value->visit(v); }
@@ -202,12 +468,53 @@ protected:
 // TODO: support const variant
 using const_variant = variant;
 
+// non-owning reference, to return shared mirror as variant
+
+class mirror_ref : public base_mirror
+{
+public:
+    explicit mirror_ref(base_mirror& value) : value(&value) {}
+
+    size_t size() const override { return value->size(); }
+    void * addr() override { return value->addr(); }
+    void addr(void *addr) override { value->addr(addr); }
+    void link(uint8_t *const *root, ptrdiff_t offset) override { value->link(root, offset); }
+    const char *type() const override { return value->type(); }
+    mirror_kind kind() const override { return value->kind(); }
+    void *as_kind(mirror_kind kind) override { return value->as_kind(kind); }
+    uint32_t attr_bits() const override { return value->attr_bits(); }
+    void *find_attr(uint32_t bit) override { return value->find_attr(bit); }
+    void *find_mapping(const void *key) override { return value->find_mapping(key); }
+    bool marked() const override { return value->marked(); }
+    bool subtree_marked() const override { return value->subtree_marked(); }
+
+    void visit(visitor& v) override { value->visit(v); }
+    void visit(const_visitor& v) const override { value->visit(v); }
+
+protected:
+    base_mirror *value;
+};
+
+// owning reference, to return a mirror that can't be moved into variant
+
+class mirror_box : public mirror_ref
+{
+public:
+    explicit mirror_box(std::unique_ptr<base_mirror> owned) :
+        mirror_ref(*owned), owned(std::move(owned)) {}
+
+private:
+    std::unique_ptr<base_mirror> owned;
+};
+
 // arrays
 
 struct array_mirror : virtual base_mirror
 {
     virtual size_t count() const = 0;
 
+    // the element mirror is not a field: writes through it are not marked
+    // for observer and dirty_tracker, use set(i, value) of typed arrays
     virtual variant operator[](size_t i) = 0;
     const_variant operator[](size_t i) const { return const_cast<array_mirror *>(this)->operator[](i); }
 
@@ -215,6 +522,7 @@ struct array_mirror : virtual base_mirror
     const_variant at(size_t i) const { return const_cast<array_mirror *>(this)->at(i); }
 
     VISIT_IMPL;
+    MIRROR_KIND(ARRAY, base_mirror);
 };
 
 template<typename T>
@@ -228,9 +536,16 @@ struct typed_array : array_mirror
     size_t size() const override { return len * sizeof(T); }
     void * addr() override { return raw; }
     void addr(void *addr) override { raw = reinterpret_cast<T *>(addr); }
-
-    const T& get(size_t i) { return raw[i]; }
-    void set(size_t i, const T& value) { raw[i] = value; }
+    void link(uint8_t *const *root, ptrdiff_t offset) override { raw.link(root, offset); }
+
+    const T& get(size_t i) { INTROSPECT_TOUCH(this); return raw[i]; }
+    void set(size_t i, const T& value) {
+        INTROSPECT_TOUCH(this);
+        if (differs(raw[i], value, 0)) {
+            raw[i] = value;
+            this->mark_changed();
+        }
+    }
 
     variant operator[](size_t i) override { 
         if (i >= len)
@@ -239,7 +554,7 @@ struct typed_array : array_mirror
     }
 
 protected:
-    T *     raw;
+    value_ptr<T> raw;
     size_t  len;
 };
 
@@ -258,9 +573,9 @@ struct mirror<E[N]> : typed_array<E>
     using typed_array<E>::get;
     using typed_array<E>::set;
 
-    T& get() { return *reinterpret_cast<T *>(raw); }
-    const T& get() const { return *reinterpret_cast<T *>(raw); }
-    const char *type() const override { return typeid(T).name(); }
+    T& get() { return *reinterpret_cast<T *>(this->raw.get()); }
+    const T& get() const { return *reinterpret_cast<T *>(this->raw.get()); }
+    const char *type() const override { return type_name<T>(); }
 
 };
 
@@ -274,8 +589,59 @@ struct mirror<std::array<E, N>> : mirror<E[N]>
         mirror<E[N]>(raw.data(), N) {}
 };
 
+// dynamic arrays
+
+struct vector_mirror : array_mirror
+{
+    VISIT_IMPL;
+    MIRROR_KIND(VECTOR, array_mirror);
+
+    virtual void resize(size_t count) = 0;
+    virtual void reserve(size_t count) = 0;
+    virtual size_t capacity() const = 0;
+};
+
+template<typename E>
+struct mirror<std::vector<E>> : typed_mirror<std::vector<E>, vector_mirror>
+{
+    using T = std::vector<E>;
+
+    mirror() = default;
+    mirror(const mirror& that) = default;
+    explicit mirror(T& raw) : typed_mirror<T, vector_mirror>(raw) {}
+
+    using typed_mirror<T, vector_mirror>::get;
+    using typed_mirror<T, vector_mirror>::set;
+
+    const E& get(size_t i) const { INTROSPECT_TOUCH(this); return (*this->raw)[i]; }
+    void set(size_t i, const E& value) {
+        INTROSPECT_TOUCH(this);
+        if (differs((*this->raw)[i], value, 0)) {
+            (*this->raw)[i] = value;
+            this->mark_changed();
+        }
+    }
+
+    size_t count() const override { return this->raw->size(); }
+    size_t capacity() const override { return this->raw->capacity(); }
+    void resize(size_t count) override {
+        if (count != this->raw->size()) {
+            this->raw->resize(count);
+            this->mark_changed();
+        }
+    }
+    void reserve(size_t count) override { this->raw->reserve(count); }
+
+    variant operator[](size_t i) override {
+        if (i >= count())
+            throw bad_idx_error(i, count());
+        return mirror<E>((*this->raw)[i]);
+    }
+};
+
 static_assert(sizeof(mirror<int>) <= VARIANT_BUFFER_SIZE, "VARIANT_BUFFER_SIZE is insufficient");
 static_assert(sizeof(mirror<int[1]>) <= VARIANT_BUFFER_SIZE, "VARIANT_BUFFER_SIZE is insufficient");
+static_assert(sizeof(mirror<std::string>) <= VARIANT_BUFFER_SIZE, "VARIANT_BUFFER_SIZE is insufficient");
 
 
 INTROSPECT_NS_CLOSE;
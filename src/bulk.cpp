@@ -0,0 +1,73 @@
+#include "introspect/bulk.h"
+#include <cstring>
+
+INTROSPECT_NS_OPEN;
+
+std::vector<record_range> split_records(const char *data, size_t size)
+{
+    std::vector<record_range> records;
+
+    size_t pos = 0, line = 1;
+    record_range record = { 0, 0, 0 };
+    bool in_record = false;
+    while (pos < size) {
+        auto *eol = static_cast<const char *>(memchr(data + pos, '\n', size - pos));
+        size_t end = eol ? eol - data + 1 : size;
+
+        bool empty = true;
+        for (size_t i = pos; i < end && empty; i++)
+            empty = isspace(static_cast<unsigned char>(data[i])) != 0;
+
+        if (!empty && !in_record) {
+            record = { pos, end, line };
+            in_record = true;
+        }
+        else if (!empty)
+            record.end = end;
+        else if (in_record) {
+            records.push_back(record);
+            in_record = false;
+        }
+
+        pos = end;
+        line++;
+    }
+    if (in_record)
+        records.push_back(record);
+
+    return records;
+}
+
+void parse_record(base_mirror& value, memory_istream& input, const char *data, const record_range& record)
+{
+    size_t line = record.line;
+    for (size_t pos = record.beg; pos < record.end; line++) {
+        auto *eol = static_cast<const char *>(memchr(data + pos, '\n', record.end - pos));
+        size_t end = eol ? eol - data + 1 : record.end;
+
+        try {
+            input.reset(data + pos, data + end);
+            parse_visitor parser(input);
+            value.visit(parser);
+        }
+        catch (const std::exception& error) {
+            throw record_error(line, error.what());
+        }
+        pos = end;
+    }
+}
+
+void record_errors::add(const record_error& error)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (!first || error.line < first->line)
+        first.reset(new record_error(error));
+}
+
+void record_errors::rethrow() const
+{
+    if (first)
+        throw *first;
+}
+
+INTROSPECT_NS_CLOSE;
@@ -0,0 +1,381 @@
+#include "introspect/dynamic.h"
+#include "introspect/errors.h"
+#include "introspect/path.h"
+#include <algorithm>
+
+INTROSPECT_NS_OPEN;
+
+namespace
+{
+    size_t align_up(size_t offset, size_t align)
+    {
+        return (offset + align - 1) / align * align;
+    }
+
+    bool is_int_size(size_t size)
+    {
+        return size == 1 || size == 2 || size == 4 || size == 8;
+    }
+
+    //
+    // field mirrors created at runtime
+    //
+
+    template<typename Mirror>
+    struct dynamic_field : base_field, Mirror
+    {
+        template<typename... Args>
+        dynamic_field(const char *name, ptrdiff_t offset, Args&&... args) :
+            base_field(name, offset), Mirror(std::forward<Args>(args)...) {}
+    };
+
+    template<typename E>
+    struct dynamic_array : typed_array<E>
+    {
+        explicit dynamic_array(size_t count) :
+            typed_array<E>(nullptr, count) {}
+
+        const char *type() const override { return type_name<E>(); }
+    };
+
+    template<typename T>
+    struct dynamic_enum : typed_mirror<T, enum_mirror>
+    {
+        explicit dynamic_enum(array_ptr<const enum_option> options) :
+            m_options(options) {}
+        dynamic_enum(array_ptr<const enum_option> options, T& raw) :
+            typed_mirror<T, enum_mirror>(raw), m_options(options) {}
+
+        int64_t int_value() const override { INTROSPECT_TOUCH(this); return *this->raw; }
+        void int_value(int64_t value) override { this->set(static_cast<T>(value)); }
+        array_ptr<const enum_option> options() const override { return m_options; }
+
+    private:
+        array_ptr<const enum_option> m_options;
+    };
+
+    template<typename T>
+    struct dynamic_enum_array : dynamic_array<T>
+    {
+        dynamic_enum_array(size_t count, array_ptr<const enum_option> options) :
+            dynamic_array<T>(count), m_options(options) {}
+
+        variant operator[](size_t i) override {
+            if (i >= this->len)
+                throw bad_idx_error(i, this->len);
+            return dynamic_enum<T>(m_options, this->raw[i]);
+        }
+
+    private:
+        array_ptr<const enum_option> m_options;
+    };
+
+    struct dynamic_struct_array : struct_array_mirror
+    {
+        dynamic_struct_array(const schema& schema, size_t count) :
+            m_element(schema, nullptr), m_count(count) {}
+
+        size_t count() const override { return m_count; }
+        size_t size() const override { return m_count * m_element.size(); }
+        void *addr() override { return raw; }
+        void addr(void *addr) override { raw = static_cast<uint8_t *>(addr); }
+        void link(uint8_t *const *root, ptrdiff_t offset) override { raw.link(root, offset); }
+        const char *type() const override { return m_element.type(); }
+
+        struct_mirror& element(size_t i) override {
+            if (i >= m_count)
+                throw bad_idx_error(i, m_count);
+            m_element.addr(raw + i * m_element.size());
+            return m_element;
+        }
+
+        variant operator[](size_t i) override {
+            if (i >= m_count)
+                throw bad_idx_error(i, m_count);
+            auto *item = raw + i * m_element.size();
+            return mirror_box(std::unique_ptr<base_mirror>(new dynamic_struct_mirror(m_element.get_schema(), item)));
+        }
+
+    private:
+        value_ptr<uint8_t>      raw;
+        dynamic_struct_mirror   m_element;
+        size_t                  m_count;
+    };
+
+    template<typename T>
+    base_field *make_int(const schema_field& field)
+    {
+        bool array = field.kind == value_kind::ARRAY;
+        if (field.item_kind == value_kind::ENUM) {
+            if (array)
+                return new dynamic_field<dynamic_enum_array<T>>(field.name, field.offset, field.count, field.options);
+            return new dynamic_field<dynamic_enum<T>>(field.name, field.offset, field.options);
+        }
+        if (array)
+            return new dynamic_field<dynamic_array<T>>(field.name, field.offset, field.count);
+        return new dynamic_field<mirror<T>>(field.name, field.offset);
+    }
+
+    template<typename T>
+    base_field *make_value(const schema_field& field)
+    {
+        if (field.kind == value_kind::ARRAY)
+            return new dynamic_field<dynamic_array<T>>(field.name, field.offset, field.count);
+        return new dynamic_field<mirror<T>>(field.name, field.offset);
+    }
+
+    // scalars, strings and their arrays
+    base_field *make_field(const schema_field& field)
+    {
+        bool is_signed = field.is_signed;
+        switch (field.item_kind) {
+        case value_kind::INT:
+        case value_kind::ENUM:
+            if (field.flags & IS_BOOL)
+                return make_int<bool>(field);
+            switch (field.item_size) {
+            case 1: return is_signed ? make_int<int8_t>(field) : make_int<uint8_t>(field);
+            case 2: return is_signed ? make_int<int16_t>(field) : make_int<uint16_t>(field);
+            case 4: return is_signed ? make_int<int32_t>(field) : make_int<uint32_t>(field);
+            case 8: return is_signed ? make_int<int64_t>(field) : make_int<uint64_t>(field);
+            }
+            break;
+        case value_kind::FLOAT:
+            switch (field.item_size) {
+            case 4: return make_value<float>(field);
+            case 8: return make_value<double>(field);
+            }
+            break;
+        case value_kind::STRING:
+            return make_value<std::string>(field);
+        default:
+            break;
+        }
+        throw not_implemented(__FUNCTION__);
+    }
+}
+
+//
+// dynamic_schema
+//
+
+dynamic_schema::dynamic_schema(const char *name) :
+    schema(nullptr, 0, 1)
+{
+    m_names.push_back(name);
+    set_layout(m_names.back().c_str(), 0, 1);
+}
+
+dynamic_schema::~dynamic_schema()
+{
+    forget_paths(*this);
+}
+
+dynamic_schema& dynamic_schema::add(const char *name, schema_field field, size_t count)
+{
+    // the layout changes with a new generation
+    forget_paths(*this);
+
+    m_names.push_back(name);
+    field.name = m_names.back().c_str();
+    field.item_kind = field.kind;
+    field.count = 1;
+    if (count > 1) {
+        field.kind = value_kind::ARRAY;
+        field.count = uint32_t(count);
+        field.item_ops = field.ops;
+        field.ops = nullptr;
+    }
+    field.size = uint32_t(field.item_size * field.count);
+    field.offset = ptrdiff_t(align_up(m_size, field.align));
+
+    m_size = field.offset + field.size;
+    m_align = std::max<size_t>(m_align, field.align);
+    m_fields.push_back(field);
+    set_fields(m_fields.data(), m_fields.size() * sizeof(schema_field));
+    set_layout(m_names.front().c_str(), align_up(m_size, m_align), m_align);
+    return *this;
+}
+
+dynamic_schema& dynamic_schema::add_int(const char *name, size_t size, bool is_signed, size_t count)
+{
+    if (!is_int_size(size))
+        throw not_implemented(__FUNCTION__);
+    schema_field field = {};
+    field.kind = value_kind::INT;
+    field.item_size = uint32_t(size);
+    field.align = uint32_t(size);
+    field.is_signed = is_signed;
+    return add(name, field, count);
+}
+
+dynamic_schema& dynamic_schema::add_bool(const char *name, size_t count)
+{
+    schema_field field = {};
+    field.kind = value_kind::INT;
+    field.item_size = sizeof(bool);
+    field.align = alignof(bool);
+    field.flags = IS_BOOL;
+    return add(name, field, count);
+}
+
+dynamic_schema& dynamic_schema::add_float(const char *name, size_t size, size_t count)
+{
+    if (size != sizeof(float) && size != sizeof(double))
+        throw not_implemented(__FUNCTION__);
+    schema_field field = {};
+    field.kind = value_kind::FLOAT;
+    field.item_size = uint32_t(size);
+    field.align = uint32_t(size);
+    field.is_signed = true;
+    return add(name, field, count);
+}
+
+dynamic_schema& dynamic_schema::add_enum(const char *name, array_ptr<const enum_option> options, size_t size, size_t count)
+{
+    if (!is_int_size(size))
+        throw not_implemented(__FUNCTION__);
+    schema_field field = {};
+    field.kind = value_kind::ENUM;
+    field.item_size = uint32_t(size);
+    field.align = uint32_t(size);
+    field.is_signed = true;
+    field.options = options;
+    return add(name, field, count);
+}
+
+dynamic_schema& dynamic_schema::add_string(const char *name, size_t count)
+{
+    schema_field field = {};
+    describe_type<std::string>::fill(field);
+    field.item_size = sizeof(std::string);
+    field.align = alignof(std::string);
+    return add(name, field, count);
+}
+
+dynamic_schema& dynamic_schema::add_struct(const char *name, const schema& nested, size_t count)
+{
+    schema_field field = {};
+    field.kind = value_kind::STRUCT;
+    field.item_size = uint32_t(nested.size());
+    field.align = uint32_t(nested.align());
+    field.nested = &nested;
+    return add(name, field, count);
+}
+
+//
+// dynamic_struct_mirror
+//
+
+dynamic_struct_mirror::dynamic_struct_mirror(const schema& schema) :
+    dynamic_struct_mirror(schema, nullptr)
+{
+    m_buffer.reset(new uint8_t[std::max<size_t>(schema.size(), 1)]());
+    construct(schema, m_buffer.get());
+    addr(m_buffer.get());
+}
+
+dynamic_struct_mirror::dynamic_struct_mirror(const schema& schema, void *addr) :
+    m_schema(&schema), m_raw(static_cast<uint8_t *>(addr))
+{
+    for (auto& field : schema) {
+        dynamic_field<dynamic_struct_mirror> *nested = nullptr;
+        base_field *created;
+        if (field.kind == value_kind::STRUCT)
+            created = nested = new dynamic_field<dynamic_struct_mirror>(field.name, field.offset, *field.nested, nullptr);
+        else if (field.kind == value_kind::ARRAY && field.item_kind == value_kind::STRUCT)
+            created = new dynamic_field<dynamic_struct_array>(field.name, field.offset, *field.nested, field.count);
+        else if (field.kind == value_kind::VECTOR)
+            throw not_implemented(__FUNCTION__);
+        else
+            created = make_field(field);
+
+        m_fields.emplace_back(created);
+        m_offsets.push_back({ ptrdiff_t(created) });
+
+        // nested fields follow their struct
+        m_table.push_back(created);
+        m_paths.push_back(field.name);
+        if (nested) {
+            for (size_t i = 0; i < nested->table_size(); i++) {
+                m_table.push_back(&nested->field(i));
+                m_paths.push_back(std::string(field.name) + "." + nested->path_of(i));
+            }
+        }
+    }
+    relink();
+}
+
+dynamic_struct_mirror::~dynamic_struct_mirror()
+{
+    if (m_buffer)
+        destroy(*m_schema, m_buffer.get());
+}
+
+void dynamic_struct_mirror::addr(void *addr)
+{
+    bool linked = m_raw.linked();
+    m_raw = static_cast<uint8_t *>(addr);
+    if (linked) // fields followed another root
+        relink();
+}
+
+void dynamic_struct_mirror::link(uint8_t *const *root, ptrdiff_t offset)
+{
+    m_raw.link(root, offset);
+    for (auto& field : m_fields)
+        field->link(root, offset + field->offset);
+}
+
+void dynamic_struct_mirror::relink()
+{
+    for (auto& field : m_fields)
+        field->link(m_raw.root(), m_raw.offset() + field->offset);
+}
+
+field_set<base_field> dynamic_struct_mirror::fields()
+{
+    // offsets are addresses of the fields
+    return field_set<base_field>(0, m_offsets.data(), m_offsets.data() + m_offsets.size());
+}
+
+size_t dynamic_struct_mirror::index_of(const char *path) const
+{
+    for (size_t i = 0; i < m_paths.size(); i++) {
+        if (m_paths[i] == path)
+            return i;
+    }
+    throw bad_key_error(path, type());
+}
+
+void dynamic_struct_mirror::construct(const schema& schema, void *addr)
+{
+    auto *base = static_cast<uint8_t *>(addr);
+    for (auto& field : schema) {
+        auto *value = base + field.offset;
+        for (size_t i = 0; i < field.count; i++, value += field.item_size) {
+            if (field.item_kind == value_kind::STRING)
+                new (value) std::string();
+            else if (field.item_kind == value_kind::STRUCT)
+                construct(*field.nested, value);
+            else if (field.kind == value_kind::VECTOR)
+                throw not_implemented(__FUNCTION__);
+        }
+    }
+}
+
+void dynamic_struct_mirror::destroy(const schema& schema, void *addr)
+{
+    auto *base = static_cast<uint8_t *>(addr);
+    for (auto& field : schema) {
+        auto *value = base + field.offset;
+        for (size_t i = 0; i < field.count; i++, value += field.item_size) {
+            if (field.item_kind == value_kind::STRING)
+                reinterpret_cast<std::string *>(value)->~basic_string();
+            else if (field.item_kind == value_kind::STRUCT)
+                destroy(*field.nested, value);
+        }
+    }
+}
+
+INTROSPECT_NS_CLOSE;
@@ -1,5 +1,6 @@
 #include "introspect/errors.h"
 #include "introspect/io.h"
+#include "introspect/bulk.h"
 #include <sstream>
 
 using namespace introspect;
@@ -26,11 +27,19 @@ bad_key_error::bad_key_error(const char *key, const char *dict) :
     std::out_of_range(beg() << "Key not found: " << dict << "::" << key <= end()),
     key(key) {}
 
+bad_value_error::bad_value_error(const char *key) :
+    std::out_of_range(beg() << "Value out of range: " << key <= end()),
+    key(key) {}
+
 token_error::token_error(const scanner::token& token) :
     parse_error(beg() << "Unexpected token "
         << scanner::token_name(token.type) << " at pos " << token.pos <= end()),
     token(scanner::token_name(token.type)), pos(pos) {}
 
+record_error::record_error(size_t line, const std::string& message) :
+    parse_error(beg() << "Line " << line << ": " << message <= end()),
+    line(line) {}
+
 low_count_error::low_count_error(size_t count, size_t min_count) :
     parse_error(beg() << "Count too low: " << count << " < " << min_count <= end()),
     count(count), min_count(min_count) {}
@@ -3,6 +3,11 @@
 #include "introspect/attrib.h"
 #include "introspect/errors.h"
 #include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <utility>
 
 INTROSPECT_NS_OPEN;
 
@@ -10,31 +15,44 @@ INTROSPECT_NS_OPEN;
 // printer
 //
 
+namespace
+{
+    void print_path(std::ostream& out, const context_t& context)
+    {
+        for (auto i = context.begin(); i != context.end(); ++i) {
+            if (!i->field)
+                out << "[" << i->index << "]";
+            else if (i == context.begin())
+                out << i->field->name();
+            else
+                out << "." << i->field->name();
+        }
+    }
+}
+
 std::ostream& operator<<(std::ostream& out, const context_t& context)
 {
-    auto i = context.begin();
-    if (i != context.end()) {
-        out << (*i)->name();
-        while (++i != context.end())
-            out << "." << (*i)->name();
+    print_path(out, context);
+    if (!context.empty())
         out << " = ";
-    }
     return out;
 };
 
 void print_visitor::visit(const int_mirror& value)
 {
-    out << context << value.int_value() << end();
+    out << begin() << context << value.int_value() << end();
 }
 
 void print_visitor::visit(const float_mirror& value)
 {
-    out << context << value.float_value() << end();
+    char text[32];
+    print_float(text, sizeof(text), value.float_value(), value.size() == sizeof(float));
+    out << begin() << context << text << end();
 }
 
 void print_visitor::visit(const enum_mirror& value)
 {
-    out << context;
+    out << begin() << context;
     auto int_value = value.int_value();
     for (auto& pair : value.options()) {
         if (pair.value == int_value) {
@@ -47,21 +65,138 @@ void print_visitor::visit(const enum_mirror& value)
 
 void print_visitor::visit(const array_mirror& value)
 {
-    out << context << "{ " << value[0];
-    for (size_t i = 1, n = value.count(); i < n; i++)
-        out << ", " << value[i];
+    out << begin() << context << "{";
+    size_t count = value.count();
+    if (count) {
+        // elements are contiguous: rebind one mirror instead of creating them
+        auto item = value[0];
+        auto *base = static_cast<uint8_t *>(item.addr());
+        size_t stride = item.size();
+        for (size_t i = 0; i < count; i++) {
+            item.addr(base + i * stride);
+            out << (i ? ", " : " ") << item;
+        }
+    }
     out << " }" << end();
 }
 
+void print_visitor::visit(const string_mirror& value)
+{
+    out << begin() << context;
+    print_string(out, value.str_value(), value.length());
+    out << end();
+}
+
+void print_string(std::ostream& out, const char *str, size_t length)
+{
+    out << '"';
+    for (size_t i = 0; i < length; i++) {
+        switch (str[i]) {
+        case '"':  out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        default:   out << str[i];
+        }
+    }
+    out << '"';
+}
+
+int print_float(char *buffer, size_t size, double value, bool single) noexcept
+{
+    int length = 0;
+    for (int precision = 1; precision <= 17; precision++) {
+        length = snprintf(buffer, size, "%.*g", precision, value);
+        if (length < 0 || size_t(length) >= size)
+            return length;
+        double back = strtod(buffer, nullptr);
+        if (single ? float(back) == float(value) : back == value)
+            break;
+    }
+    return length;
+}
+
 void print_visitor::visit(const struct_mirror& value)
 {
-    for (auto& field : value.fields()) {
-        context.push(field);
-        field.visit(*this);
+    if (grouped && !context.empty()) {
+        // names in the block are relative to the struct
+        out << begin();
+        print_path(out, context);
+        out << " {";
+
+        context_t outer;
+        std::swap(outer, context);
+        blocks++;
+        first = true;
+        print_fields(value);
+        blocks--;
+        first = false;
+        std::swap(outer, context);
+
+        out << " }" << end();
+        return;
+    }
+
+    print_fields(value);
+}
+
+void print_visitor::print_fields(const struct_mirror& value)
+{
+    if (marked_only)
+        for_each_marked(value, [this](const base_field& field) { print_field(field); });
+    else {
+        for (auto& field : value.fields())
+            print_field(field);
+    }
+}
+
+void print_visitor::print_field(const base_field& field)
+{
+    // marked field is printed as a whole, other structs for their marked fields
+    bool filter = marked_only;
+    if (filter && field.marked())
+        marked_only = false;
+
+    context.push(field);
+    field.visit(*this);
+    context.pop();
+    marked_only = filter;
+}
+
+void print_visitor::visit(const struct_array_mirror& value)
+{
+    for (size_t i = 0, n = value.count(); i < n; i++) {
+        context.push(i);
+        value.element(i).visit(*this);
         context.pop();
     }
 }
 
+//
+// memory_buffer
+//
+
+memory_buffer::pos_type memory_buffer::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if (which & std::ios_base::out)
+        return pos_type(off_type(-1));
+
+    auto *pos = dir == std::ios_base::beg ? eback() :
+                dir == std::ios_base::end ? egptr() : gptr();
+    pos += off;
+    if (pos < eback() || pos > egptr())
+        return pos_type(off_type(-1));
+
+    setg(eback(), pos, egptr());
+    return pos_type(pos - eback());
+}
+
+memory_buffer::pos_type memory_buffer::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
 //
 // scanner
 //
@@ -100,9 +235,12 @@ scanner::token scanner::read()
     if (c == '\n' || c == std::istream::traits_type::eof())
         return{ pos, scanner::EOL };
 
-    if (c == '.' || c == '=' || c == '{' || c == '}' || c == ',')
+    if (c == '.' || c == '=' || c == '{' || c == '}' || c == ',' || c == '[' || c == ']')
         return{ pos, c };
 
+    if (c == '"')
+        return read_string(pos);
+
     if (isalpha(c)) {
         input.unget();
         read_while(token_text, MAX_TOKEN_LENGTH, isalnum);
@@ -129,9 +267,24 @@ scanner::token scanner::read()
 
         end += read_while(end, 32, isdigit);
 
-        if (input.peek() == '.') {
+        bool fraction = input.peek() == '.';
+        if (fraction) {
             *end++ = input.get();
             end += read_while(end, 32, isdigit);
+        }
+
+        // exponent, as floats are printed: 1e-05
+        bool exponent = tolower(input.peek()) == 'e';
+        if (exponent) {
+            *end++ = input.get();
+            if (input.peek() == '-' || input.peek() == '+')
+                *end++ = input.get();
+            if (!isdigit(input.peek()))
+                throw token_error({ scanner::position_t(input.tellg()), input.peek() });
+            end += read_while(end, 8, isdigit);
+        }
+
+        if (fraction || exponent) {
             double value = strtod(token_text, nullptr);
             return{ pos, value };
         }
@@ -143,6 +296,34 @@ scanner::token scanner::read()
     throw token_error({ pos, c });
 }
 
+scanner::token scanner::read_string(position_t pos)
+{
+    string_text.clear();
+    while (true) {
+        auto c = input.get();
+        if (c == '"')
+            break;
+        if (c == '\n' || c == std::istream::traits_type::eof())
+            throw token_error({ scanner::position_t(input.tellg()), scanner::EOL });
+        if (c == '\\') {
+            c = input.get();
+            switch (c) {
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            case '"': case '\\': break;
+            default:
+                throw token_error({ scanner::position_t(input.tellg()), c });
+            }
+        }
+        string_text.push_back(char(c));
+    }
+
+    token t(pos, string_text.c_str());
+    t.type = STRING;
+    return t;
+}
+
 scanner::token scanner::expect_impl(const int *expected_type, const int *end)
 {
     auto& t = peek();
@@ -162,7 +343,8 @@ std::string scanner::token_name(int type) {
         "end-of-line",
         "identifier",
         "integer",
-        "float"
+        "float",
+        "string"
     };
     return names[type - EOL];
 }
@@ -174,27 +356,39 @@ std::string scanner::token_name(int type) {
 void parse_visitor::visit(int_mirror& value)
 {
     auto token = input.expect(scanner::INT);
+    auto old = value.int_value();
     value.int_value(token.int_value);
+    modified |= value.int_value() != old;
 }
 
 void parse_visitor::visit(float_mirror& value)
 {
     auto token = input.expect(scanner::INT, scanner::FLOAT);
+    auto old = value.float_value();
     value.float_value(token.type == scanner::INT ? 
         token.int_value : token.float_value);
+    modified |= value.float_value() != old;
 }
 
 void parse_visitor::visit(enum_mirror& value)
 {
     auto token = input.expect(scanner::INT, scanner::NAME);
+    auto old = value.int_value();
     if (token.type == scanner::NAME) {
+        const enum_option *option = nullptr;
         for (auto& var : value.options()) {
-            if (0 == strcmp(var.name, token.name))
-                return value.int_value(var.value);
+            if (0 == strcmp(var.name, token.name)) {
+                option = &var;
+                break;
+            }
         }
-        throw bad_key_error(token.name, value.type());
+        if (!option)
+            throw bad_key_error(token.name, value.type());
+        value.int_value(option->value);
     }
-    value.int_value(token.int_value);
+    else
+        value.int_value(token.int_value);
+    modified |= value.int_value() != old;
 }
 
 void parse_visitor::visit(array_mirror& value)
@@ -203,10 +397,12 @@ void parse_visitor::visit(array_mirror& value)
     if (brace) // skip opening brace
         input.get();
 
-    auto* limit = dynamic_cast<with_min_count*>(&value);
+    auto* limit = attr_cast<with_min_count>(&value);
     size_t max_count = value.count();
     size_t min_count = limit ? limit->get_min_count() : max_count;
 
+    bool outer = modified;
+    modified = false;
     value[0].visit(*this);
 
     size_t count = 1;
@@ -225,8 +421,58 @@ void parse_visitor::visit(array_mirror& value)
     if (count < min_count)
         throw low_count_error(count, min_count);
     
-    if (count < max_count)
+    if (count < max_count && limit->get_filler())
         limit->get_filler()->fill(count, max_count);
+
+    // elements are modified through their own mirrors
+    if (modified)
+        value.mark_changed();
+    modified |= outer;
+}
+
+void parse_visitor::visit(vector_mirror& value)
+{
+    int brace = input.peek().type == '{' ? '}' : 0;
+    if (brace) // skip opening brace
+        input.get();
+
+    // reuse the elements and capacity of the current value,
+    // std::vector grows geometrically for the rest
+    bool outer = modified;
+    modified = false;
+    size_t count = 0;
+    if (input.peek().type != (brace ? brace : scanner::EOL)) {
+        while (true) {
+            if (count == value.count())
+                value.resize(count + 1);
+            value[count++].visit(*this);
+
+            auto delim = input.expect(',', brace ? brace : scanner::EOL);
+            if (delim.type != ',') {
+                input.unget(delim);
+                break;
+            }
+        }
+    }
+    value.resize(count);
+
+    if (brace) // expect closing brace
+        input.expect(brace);
+
+    auto* limit = attr_cast<with_min_count>(&value);
+    if (limit && count < limit->get_min_count())
+        throw low_count_error(count, limit->get_min_count());
+
+    if (modified)
+        value.mark_changed();
+    modified |= outer;
+}
+
+void parse_visitor::visit(string_mirror& value)
+{
+    auto token = input.expect(scanner::STRING);
+    modified |= 0 != strcmp(value.str_value(), token.name);
+    value.str_value(token.name);
 }
 
 void parse_visitor::visit(struct_mirror& value)
@@ -236,15 +482,146 @@ void parse_visitor::visit(struct_mirror& value)
         return;
     auto& field = value[name.name];
 
-    auto *nested_struct = dynamic_cast<struct_mirror *>(&field);
-    input.expect(nested_struct ? '.' : '=');
-
+    // structs continue with path or block, struct arrays with index
+    auto kind = field.kind();
     context.push(field);
-    field.visit(*this);
+    if (kind == mirror_kind::STRUCT && input.expect('.', '{').type == '{')
+        parse_block(*mirror_cast<struct_mirror>(&field));
+    else {
+        bool value = kind != mirror_kind::STRUCT && kind != mirror_kind::STRUCT_ARRAY;
+        if (value)
+            input.expect('=');
+        field.visit(*this);
+        if (value && on_value)
+            on_value(context);
+    }
     context.pop();
 
     if (context.empty())
         input.expect(scanner::EOL);
 }
 
+void parse_visitor::visit(struct_array_mirror& value)
+{
+    input.expect('[');
+    auto index = input.expect(scanner::INT);
+    input.expect(']');
+    bool block = input.expect('.', '{').type == '{';
+
+    bool outer = modified;
+    modified = false;
+    context.push(size_t(index.int_value));
+    auto& element = value.element(size_t(index.int_value));
+    if (block)
+        parse_block(element);
+    else
+        element.visit(*this);
+    context.pop();
+
+    if (modified)
+        value.mark_changed();
+    modified |= outer;
+
+    if (context.empty())
+        input.expect(scanner::EOL);
+}
+
+// "{ X = 10, Y = 11 }" after the opening brace, the fields may be
+// on separate lines and followed by a comma before the closing brace;
+// fields are resolved in the struct, not from the root
+void parse_visitor::parse_block(struct_mirror& value)
+{
+    while (true) {
+        skip_lines();
+        if (input.peek().type == '}') {
+            input.get();
+            return;
+        }
+        value.visit(*this);
+        skip_lines();
+        if (input.expect(',', '}').type == '}')
+            return;
+    }
+}
+
+// line breaks inside of a block
+void parse_visitor::skip_lines()
+{
+    while (input.peek().type == scanner::EOL) {
+        if (input.at_end())
+            throw token_error(input.peek());
+        input.get();
+    }
+}
+
+//
+// push parser
+//
+
+namespace
+{
+    bool is_blank_line(const char *beg, const char *end)
+    {
+        for (; beg != end; beg++) {
+            if (*beg != ' ' && *beg != '\t' && *beg != '\r' && *beg != '\n')
+                return false;
+        }
+        return true;
+    }
+}
+
+void push_parser::apply(const char *beg, const char *end)
+{
+    input.reset(beg, end);
+    parse_visitor parser(input);
+    value.visit(parser);
+}
+
+push_parser::result push_parser::feed(const char *data, size_t size)
+{
+    result result;
+
+    const char *end = data + size;
+    while (data != end) {
+        auto *eol = static_cast<const char *>(memchr(data, '\n', end - data));
+        if (!eol) {
+            line.append(data, end);
+            break;
+        }
+
+        auto *next = eol + 1;
+        const char *beg = data;
+        if (!line.empty()) {
+            line.append(data, next);
+            beg = line.data();
+            next = beg + line.size();
+        }
+        if (!is_blank_line(beg, next)) {
+            try {
+                apply(beg, next);
+                result.applied++;
+            }
+            catch (...) {
+                if (!result.error)
+                    result.error = std::current_exception();
+                result.failed++;
+            }
+        }
+        line.clear();
+        data = eol + 1;
+    }
+    return result;
+}
+
+size_t push_parser::finish()
+{
+    std::string last;
+    last.swap(line);
+    if (is_blank_line(last.data(), last.data() + last.size()))
+        return 0;
+
+    apply(last.data(), last.data() + last.size());
+    return 1;
+}
+
 INTROSPECT_NS_CLOSE;
@@ -0,0 +1,133 @@
+#include "introspect/layers.h"
+#include "introspect/errors.h"
+
+INTROSPECT_NS_OPEN;
+
+namespace
+{
+    bool test(const uint64_t *bits, size_t i)
+    {
+        return 0 != (bits[i / 64] & (uint64_t(1) << i % 64));
+    }
+
+    // "pts[1].X", the same as the printer writes
+    void path_of(const context_t& context, std::string& path)
+    {
+        path.clear();
+        for (auto i = context.begin(); i != context.end(); ++i) {
+            if (!i->field)
+                path.append("[").append(std::to_string(i->index)).append("]");
+            else {
+                if (i != context.begin())
+                    path.push_back('.');
+                path.append(i->field->name());
+            }
+        }
+    }
+
+    void copy_fields(struct_mirror& dst, const struct_mirror& src, const uint64_t *bits, size_t& i)
+    {
+        auto fields = dst.fields();
+        auto to = fields.begin();
+        for (auto& from : src.fields()) {
+            auto& field = *to;
+            ++to;
+            if (auto *nested = mirror_cast<struct_mirror>(&from))
+                copy_fields(*mirror_cast<struct_mirror>(&field), *nested, bits, i);
+            else if (auto *array = mirror_cast<struct_array_mirror>(&from)) {
+                auto *target = mirror_cast<struct_array_mirror>(&field);
+                for (size_t e = 0; e < array->count(); e++)
+                    copy_fields(target->element(e), array->element(e), bits, i);
+            }
+            else if (test(bits, i++))
+                assign(field, from);
+        }
+    }
+}
+
+void assign(base_mirror& dst, const base_mirror& src)
+{
+    switch (src.kind()) {
+    case mirror_kind::INT:
+    case mirror_kind::ENUM:
+        mirror_cast<int_mirror>(&dst)->int_value(mirror_cast<int_mirror>(&src)->int_value());
+        return;
+    case mirror_kind::FLOAT:
+        mirror_cast<float_mirror>(&dst)->float_value(mirror_cast<float_mirror>(&src)->float_value());
+        return;
+    case mirror_kind::STRING: {
+        auto *str = mirror_cast<string_mirror>(&src);
+        mirror_cast<string_mirror>(&dst)->str_value(str->str_value(), str->length());
+        return;
+    }
+    case mirror_kind::VECTOR:
+        mirror_cast<vector_mirror>(&dst)->resize(mirror_cast<vector_mirror>(&src)->count());
+        // elements as in array
+    case mirror_kind::ARRAY: {
+        auto *from = mirror_cast<array_mirror>(&src);
+        auto *to = mirror_cast<array_mirror>(&dst);
+        for (size_t i = 0, n = from->count(); i < n; i++) {
+            auto item = (*to)[i];
+            assign(item, (*from)[i]);
+        }
+        return;
+    }
+    default:
+        throw not_implemented(__FUNCTION__);
+    }
+}
+
+//
+// field_index
+//
+
+field_index::field_index(struct_mirror& value)
+{
+    add_paths(value, "");
+    for (size_t i = 0; i < m_paths.size(); i++)
+        m_index[m_paths[i]] = i;
+}
+
+void field_index::add_paths(struct_mirror& value, const std::string& prefix)
+{
+    for (auto& field : value.fields()) {
+        auto path = prefix + field.name();
+        if (auto *nested = mirror_cast<struct_mirror>(&field))
+            add_paths(*nested, path + ".");
+        else if (auto *array = mirror_cast<struct_array_mirror>(&field)) {
+            for (size_t i = 0; i < array->count(); i++)
+                add_paths(array->element(i), path + "[" + std::to_string(i) + "].");
+        }
+        else
+            m_paths.push_back(path);
+    }
+}
+
+size_t field_index::index_of(const char *path) const
+{
+    auto i = m_index.find(path);
+    if (i == m_index.end())
+        throw bad_key_error(path, "field_index");
+    return i->second;
+}
+
+void field_index::parse(struct_mirror& value, std::istream& input, uint64_t *bits) const
+{
+    std::string path;
+    parse_visitor parser(input);
+    parser.on_value = [&](const context_t& context) {
+        path_of(context, path);
+        size_t i = index_of(path.c_str());
+        bits[i / 64] |= uint64_t(1) << i % 64;
+    };
+    while (!input.eof())
+        value.visit(parser);
+}
+
+void field_index::copy(struct_mirror& dst, const struct_mirror& src, const uint64_t *bits) const
+{
+    size_t i = 0;
+    copy_fields(dst, src, bits, i);
+}
+
+INTROSPECT_NS_CLOSE;
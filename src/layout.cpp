@@ -0,0 +1,125 @@
+#include "introspect/layout.h"
+#include <algorithm>
+#include <iomanip>
+
+INTROSPECT_NS_OPEN;
+
+namespace
+{
+    size_t align_up(size_t offset, size_t align)
+    {
+        return (offset + align - 1) / align * align;
+    }
+
+    // bases: offsets of every copy of the struct, elements of struct arrays
+    // are reported once at the first base, but checked at each of them
+    void add_struct(layout_report& report, const schema& schema, const std::vector<ptrdiff_t>& bases, const std::string& prefix)
+    {
+        std::vector<const schema_field *> fields;
+        for (auto& field : schema)
+            fields.push_back(&field);
+        std::stable_sort(fields.begin(), fields.end(),
+            [](const schema_field *a, const schema_field *b) { return a->offset < b->offset; });
+
+        ptrdiff_t base = bases.front();
+        auto add_hole = [&](ptrdiff_t beg, ptrdiff_t end) {
+            if (beg >= end)
+                return;
+            report.entries.push_back({ prefix + "<padding>", base + beg, size_t(end - beg), 1, true, false });
+            report.wasted += size_t(end - beg) * bases.size();
+        };
+
+        ptrdiff_t end = 0;
+        for (auto *field : fields) {
+            add_hole(end, field->offset);
+
+            auto path = prefix + field->name;
+            size_t line = report.cache_line;
+            bool straddles = false;
+            for (auto copy : bases) {
+                ptrdiff_t beg = copy + field->offset;
+                straddles |= field->size <= line && beg / line != (beg + field->size - 1) / line;
+            }
+            report.entries.push_back({ path, base + field->offset, field->size, field->align, false, straddles });
+
+            if (field->kind == value_kind::STRUCT) {
+                std::vector<ptrdiff_t> nested;
+                for (auto copy : bases)
+                    nested.push_back(copy + field->offset);
+                add_struct(report, *field->nested, nested, path + ".");
+            }
+            else if (field->kind == value_kind::ARRAY && field->item_kind == value_kind::STRUCT) {
+                std::vector<ptrdiff_t> elements;
+                for (auto copy : bases) {
+                    for (size_t i = 0; i < field->count; i++)
+                        elements.push_back(copy + field->offset + ptrdiff_t(i * field->item_size));
+                }
+                add_struct(report, *field->nested, elements, path + "[].");
+            }
+
+            end = std::max<ptrdiff_t>(end, field->offset + field->size);
+        }
+        add_hole(end, schema.size());
+    }
+}
+
+layout_report analyze_layout(const schema& schema, size_t cache_line, const std::vector<std::string>& hot)
+{
+    layout_report report;
+    report.name = schema.name();
+    report.size = schema.size();
+    report.align = schema.align();
+    report.cache_line = cache_line;
+    report.wasted = 0;
+    add_struct(report, schema, { 0 }, "");
+
+    // hot fields in the given order, the rest by alignment and size
+    auto rank = [&](const schema_field *field) {
+        auto i = std::find(hot.begin(), hot.end(), field->name);
+        return size_t(i - hot.begin());
+    };
+
+    std::vector<const schema_field *> fields;
+    for (auto& field : schema)
+        fields.push_back(&field);
+    std::stable_sort(fields.begin(), fields.end(), [&](const schema_field *a, const schema_field *b) {
+        if (rank(a) != rank(b))
+            return rank(a) < rank(b);
+        if (a->align != b->align)
+            return a->align > b->align;
+        return a->size > b->size;
+    });
+
+    size_t offset = 0;
+    for (auto *field : fields) {
+        offset = align_up(offset, field->align) + field->size;
+        report.suggested.push_back(field->name);
+    }
+    report.suggested_size = align_up(offset, schema.align());
+    return report;
+}
+
+std::ostream& operator<<(std::ostream& out, const layout_report& report)
+{
+    out << report.name << ": size " << report.size
+        << ", align " << report.align << ", wasted " << report.wasted << "\n";
+    out << "  offset   size  align  field\n";
+    for (auto& entry : report.entries) {
+        out << std::setw(8) << entry.offset << std::setw(7) << entry.size << std::setw(7);
+        if (entry.padding)
+            out << "";
+        else
+            out << entry.align;
+        out << "  " << entry.path;
+        if (entry.straddles)
+            out << "  <straddles cache line>";
+        out << "\n";
+    }
+
+    out << "suggested order, size " << report.suggested_size << ":";
+    for (size_t i = 0; i < report.suggested.size(); i++)
+        out << (i ? ", " : " ") << report.suggested[i];
+    return out << "\n";
+}
+
+INTROSPECT_NS_CLOSE;
@@ -0,0 +1,123 @@
+#include "introspect/lazy.h"
+#include "introspect/errors.h"
+#include <sstream>
+#include <cstring>
+
+INTROSPECT_NS_OPEN;
+
+lazy_document::lazy_document(std::string text, struct_mirror& root) :
+    text(std::move(text)), root(root)
+{
+    build_index();
+}
+
+lazy_document::lazy_document(std::istream& str, struct_mirror& root) :
+    text(std::istreambuf_iterator<char>(str), std::istreambuf_iterator<char>()), root(root)
+{
+    build_index();
+}
+
+void lazy_document::build_index()
+{
+    auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+
+    const char *data = text.data();
+    size_t pos = 0, size = text.size();
+    while (pos < size) {
+        size_t eol = pos;
+        while (eol < size && data[eol] != '\n')
+            eol++;
+
+        size_t beg = pos;
+        while (beg < eol && is_space(data[beg]))
+            beg++;
+
+        if (beg < eol) {
+            size_t eq = beg;
+            while (eq < eol && data[eq] != '=')
+                eq++;
+            if (eq == eol)
+                throw parse_error("Expected '=' in line: " + text.substr(beg, eol - beg));
+
+            size_t name_end = eq;
+            while (name_end > beg && is_space(data[name_end - 1]))
+                name_end--;
+
+            // blocks have several fields in a line
+            if (memchr(data + beg, '{', name_end - beg))
+                throw parse_error("Grouped format is not supported: " + text.substr(beg, eol - beg));
+
+            // the last assignment wins, as in sequential parsing
+            index[text.substr(beg, name_end - beg)] = { beg, eol, false };
+        }
+
+        pos = eol + 1;
+    }
+}
+
+void lazy_document::parse(const std::string& path, entry& value)
+{
+    if (value.parsed)
+        return;
+
+    // whole line is parsed from the root, as the path may contain indices
+    memory_istream str(text.data() + value.beg, text.data() + value.end);
+    parse_visitor parser(str);
+    root.visit(parser);
+
+    value.parsed = true;
+    parsed_count++;
+}
+
+base_field& lazy_document::at(const char *path)
+{
+    auto i = index.find(path);
+    if (i != index.end())
+        parse(i->first, i->second);
+    else if (has_prefix(path))
+        materialize(path);
+    else
+        throw bad_key_error(path, "lazy_document");
+    return root.at_path(path);
+}
+
+bool lazy_document::has_prefix(const char *path) const
+{
+    size_t len = strlen(path);
+    auto i = index.lower_bound(path);
+    for (; i != index.end() && 0 == i->first.compare(0, len, path); ++i) {
+        if (i->first[len] == '.' || i->first[len] == '[')
+            return true;
+    }
+    return false;
+}
+
+void lazy_document::materialize(const char *path)
+{
+    auto i = index.find(path);
+    if (i != index.end())
+        return parse(i->first, i->second);
+
+    // nested struct or array: parse all the fields with "path." or "path[" prefix
+    size_t len = strlen(path);
+    for (i = index.lower_bound(path); i != index.end(); ++i) {
+        auto& key = i->first;
+        if (0 != key.compare(0, len, path))
+            break;
+        if (key[len] == '.' || key[len] == '[')
+            parse(key, i->second);
+    }
+}
+
+void lazy_document::materialize()
+{
+    for (auto& pair : index)
+        parse(pair.first, pair.second);
+}
+
+bool lazy_document::contains(const char *path) const
+{
+    return index.count(path) != 0;
+}
+
+INTROSPECT_NS_CLOSE;
@@ -0,0 +1,252 @@
+#include "introspect/observe.h"
+#include "introspect/errors.h"
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+INTROSPECT_NS_OPEN;
+
+namespace
+{
+    // some bit of [beg, end) is set, tested word by word
+    bool any_bits(const uint64_t *marks, size_t beg, size_t end)
+    {
+        while (beg < end) {
+            size_t word = beg / 64, shift = beg % 64;
+            size_t count = std::min<size_t>(64 - shift, end - beg);
+            uint64_t mask = (count == 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1) << shift;
+            if (marks[word] & mask)
+                return true;
+            beg += count;
+        }
+        return false;
+    }
+
+    // index of the lowest set bit of the nonzero word
+    size_t lowest_bit(uint64_t word)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, word);
+        return index;
+#else
+        return size_t(__builtin_ctzll(word));
+#endif
+    }
+}
+
+bool base_field::subtree_marked() const
+{
+    auto& sink = m_sinks[DIRTY_SINK];
+    if (sink.marks)
+        return any_bits(sink.marks, sink.mark, sink.end);
+
+    // not tracked, but fields of the struct may be
+    return base_mirror::subtree_marked();
+}
+
+void for_each_marked(const struct_mirror& value, const std::function<void(const base_field&)>& fn)
+{
+    auto fields = value.fields();
+    auto first = fields.begin();
+    if (first == fields.end())
+        return;
+
+    // the first field is the first node of the struct subtree, unless
+    // the fields are not tracked or are of a shared struct array element
+    auto& sink = first->m_sinks[base_field::DIRTY_SINK];
+    auto *owner = sink.owner;
+    if (!sink.marks || owner->m_nodes[sink.mark].field != &*first) {
+        for (auto& field : fields) {
+            if (field.subtree_marked())
+                fn(field);
+        }
+        return;
+    }
+
+    // a set bit is in the subtree of one of the fields, the rest of the subtree is skipped
+    auto& nodes = owner->m_nodes;
+    size_t parent = nodes[sink.mark].parent;
+    size_t end = parent == field_marks::NO_PARENT ? nodes.size() : nodes[parent].end;
+    for (size_t i = field_marks::next_marked(owner->m_marks, sink.mark, end); i < end;) {
+        while (nodes[i].parent != parent)
+            i = nodes[i].parent;
+        fn(*nodes[i].field);
+        i = field_marks::next_marked(owner->m_marks, nodes[i].end, end);
+    }
+}
+
+//
+// field_marks
+//
+
+field_marks::field_marks(struct_mirror& root, size_t sink) :
+    m_sink(sink)
+{
+    add_nodes(root, "", NO_PARENT);
+    m_marks.resize((m_nodes.size() + 63) / 64);
+    for (size_t i = 0; i < m_nodes.size(); i++) {
+        auto *field = m_nodes[i].field;
+        attach(*field, i, m_nodes[i].end);
+
+        // elements of struct arrays share mirror, their changes mark the array
+        if (auto *array = mirror_cast<struct_array_mirror>(field)) {
+            if (array->count() != 0)
+                attach_nested(array->element(0), i);
+        }
+    }
+}
+
+field_marks::~field_marks()
+{
+    // the fields may be taken over by a later bitset
+    for (auto& node : m_nodes) {
+        auto& sink = node.field->m_sinks[m_sink];
+        if (sink.marks == m_marks.data())
+            sink.marks = nullptr;
+    }
+}
+
+void field_marks::add_nodes(struct_mirror& value, const std::string& prefix, size_t parent)
+{
+    for (auto& field : value.fields()) {
+        size_t index = m_nodes.size();
+        m_nodes.push_back({ prefix + field.name(), &field, 0, parent });
+        if (auto *nested = mirror_cast<struct_mirror>(&field))
+            add_nodes(*nested, m_nodes[index].path + ".", index);
+        m_nodes[index].end = m_nodes.size();
+    }
+}
+
+void field_marks::attach(base_field& field, size_t mark, size_t end)
+{
+    auto& sink = field.m_sinks[m_sink];
+    sink.marks = m_marks.data();
+    sink.mark = mark;
+    sink.end = end;
+    sink.owner = this;
+}
+
+void field_marks::attach_nested(struct_mirror& value, size_t mark)
+{
+    for (auto& field : value.fields()) {
+        attach(field, mark, mark + 1);
+        if (auto *nested = mirror_cast<struct_mirror>(&field))
+            attach_nested(*nested, mark);
+    }
+}
+
+size_t field_marks::find(const char *path) const
+{
+    if (*path == 0)
+        return NO_PARENT;
+    for (size_t i = 0; i < m_nodes.size(); i++) {
+        if (m_nodes[i].path == path)
+            return i;
+    }
+    throw bad_key_error(path, "observer");
+}
+
+std::vector<std::string> field_marks::marked_paths(const std::vector<uint64_t>& marks) const
+{
+    std::vector<std::string> paths;
+    for (size_t i = next_marked(marks, 0, m_nodes.size()); i < m_nodes.size(); i = next_marked(marks, i + 1, m_nodes.size()))
+        paths.push_back(m_nodes[i].path);
+    return paths;
+}
+
+size_t field_marks::next_marked(const std::vector<uint64_t>& marks, size_t i, size_t end)
+{
+    while (i < end) {
+        uint64_t word = marks[i / 64] >> (i % 64);
+        if (word)
+            return std::min(end, i + lowest_bit(word));
+        i = (i / 64 + 1) * 64;
+    }
+    return end;
+}
+
+bool field_marks::pending() const
+{
+    for (auto word : m_marks) {
+        if (word)
+            return true;
+    }
+    return false;
+}
+
+void field_marks::reset()
+{
+    std::fill(m_marks.begin(), m_marks.end(), 0);
+}
+
+//
+// change_set
+//
+
+bool change_set::contains(const char *path) const
+{
+    size_t i = m_owner.find(path);
+    size_t end = i == observer::NO_PARENT ? m_owner.m_nodes.size() : m_owner.m_nodes[i].end;
+    return m_owner.changed(m_marks, i == observer::NO_PARENT ? 0 : i, end);
+}
+
+std::vector<std::string> change_set::paths() const
+{
+    return m_owner.marked_paths(m_marks);
+}
+
+//
+// observer
+//
+
+bool observer::changed(const std::vector<uint64_t>& marks, size_t beg, size_t end) const
+{
+    if (any_bits(marks.data(), beg, end))
+        return true;
+
+    // the parent struct is assigned as a whole
+    for (size_t i = beg < m_nodes.size() ? m_nodes[beg].parent : NO_PARENT; i != NO_PARENT; i = m_nodes[i].parent) {
+        if (test(marks, i))
+            return true;
+    }
+    return false;
+}
+
+size_t observer::subscribe(const char *path, callback fn)
+{
+    size_t i = find(path);
+    size_t beg = i == NO_PARENT ? 0 : i;
+    size_t end = i == NO_PARENT ? m_nodes.size() : m_nodes[i].end;
+    m_subscriptions.push_back({ m_next_id, beg, end, std::move(fn) });
+    return m_next_id++;
+}
+
+void observer::unsubscribe(size_t id)
+{
+    auto i = std::find_if(m_subscriptions.begin(), m_subscriptions.end(),
+        [id](const subscription& s) { return s.id == id; });
+    if (i != m_subscriptions.end())
+        m_subscriptions.erase(i);
+}
+
+void observer::dispatch()
+{
+    if (!pending())
+        return;
+
+    // the bitset is referenced by the fields, so it is copied and cleared in place
+    std::vector<uint64_t> marks(m_marks);
+    reset();
+
+    change_set changes(*this, marks);
+    auto subscriptions = m_subscriptions;
+    for (auto& s : subscriptions) {
+        if (changed(marks, s.beg, s.end))
+            s.fn(changes);
+    }
+}
+
+INTROSPECT_NS_CLOSE;
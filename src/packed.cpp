@@ -0,0 +1,348 @@
+#include "introspect/packed.h"
+#include "introspect/errors.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+INTROSPECT_NS_OPEN;
+
+namespace
+{
+    uint64_t low_mask(uint32_t bits)
+    {
+        return bits >= 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+    }
+
+    // bits to store values 0..range
+    uint32_t bits_for(uint64_t range)
+    {
+        uint32_t bits = 0;
+        while (bits < 64 && (range >> bits) != 0)
+            bits++;
+        return bits;
+    }
+
+    //
+    // bits of the stream, a value may cross two words
+    //
+
+    // fields of single value take no bits, and may end the stream
+    uint64_t read_bits(const uint64_t *stream, size_t pos, uint32_t bits)
+    {
+        if (bits == 0)
+            return 0;
+        size_t w = pos / 64;
+        uint32_t s = pos % 64;
+        uint64_t value = stream[w] >> s;
+        if (s + bits > 64)
+            value |= stream[w + 1] << (64 - s);
+        return value & low_mask(bits);
+    }
+
+    // the bits should be clear
+    void or_bits(uint64_t *stream, size_t pos, uint64_t value, uint32_t bits)
+    {
+        if (bits == 0)
+            return;
+        size_t w = pos / 64;
+        uint32_t s = pos % 64;
+        stream[w] |= value << s;
+        if (s + bits > 64)
+            stream[w + 1] |= value >> (64 - s);
+    }
+
+    void clear_bits(uint64_t *stream, size_t pos, uint32_t bits)
+    {
+        if (bits == 0)
+            return;
+        size_t w = pos / 64;
+        uint32_t s = pos % 64;
+        uint64_t mask = low_mask(bits);
+        stream[w] &= ~(mask << s);
+        if (s + bits > 64)
+            stream[w + 1] &= ~(mask >> (64 - s));
+    }
+
+    //
+    // encoding of the values
+    //
+
+    template<typename T>
+    struct int_bits
+    {
+        static uint64_t encode(const packed_field& field, const uint8_t *value) {
+            return uint64_t(int64_t(*reinterpret_cast<const T *>(value))) - uint64_t(field.min);
+        }
+
+        static void decode(const packed_field& field, uint64_t bits, uint8_t *value) {
+            *reinterpret_cast<T *>(value) = T(int64_t(bits + uint64_t(field.min)));
+        }
+    };
+
+    // IEEE bits as they are
+    template<typename U>
+    struct float_bits
+    {
+        static uint64_t encode(const packed_field&, const uint8_t *value) {
+            U bits;
+            memcpy(&bits, value, sizeof(U));
+            return bits;
+        }
+
+        static void decode(const packed_field&, uint64_t bits, uint8_t *value) {
+            U raw = U(bits);
+            memcpy(value, &raw, sizeof(U));
+        }
+    };
+
+    // one field of all the records in a tight loop
+    template<typename Value>
+    bool pack_span(const packed_field& field, const uint8_t *records, size_t count, size_t stride,
+        uint64_t *stream, size_t index, size_t record_bits)
+    {
+        uint64_t mask = low_mask(field.bits);
+        uint64_t range = field.range;
+        bool bad = false;
+        size_t pos = index * record_bits + field.bit;
+        const uint8_t *value = records + field.offset;
+        for (size_t i = 0; i < count; i++, pos += record_bits, value += stride) {
+            uint64_t bits = Value::encode(field, value);
+            bad |= bits > range;
+            or_bits(stream, pos, bits & mask, field.bits);
+        }
+        return bad;
+    }
+
+    template<typename Value>
+    void unpack_span(const packed_field& field, const uint64_t *stream, size_t index, size_t record_bits,
+        uint8_t *records, size_t count, size_t stride)
+    {
+        size_t pos = index * record_bits + field.bit;
+        uint8_t *value = records + field.offset;
+        for (size_t i = 0; i < count; i++, pos += record_bits, value += stride)
+            Value::decode(field, read_bits(stream, pos, field.bits), value);
+    }
+
+    template<typename Value>
+    void set_codec(packed_field& packed)
+    {
+        packed.pack = &pack_span<Value>;
+        packed.unpack = &unpack_span<Value>;
+    }
+
+    void set_codec(packed_field& packed, const schema_field& field)
+    {
+        if (field.item_kind == value_kind::FLOAT) {
+            switch (field.item_size) {
+            case sizeof(float): return set_codec<float_bits<uint32_t>>(packed);
+            case sizeof(double): return set_codec<float_bits<uint64_t>>(packed);
+            }
+        }
+        else if (field.flags & IS_BOOL)
+            return set_codec<int_bits<bool>>(packed);
+        else {
+            bool is_signed = field.is_signed;
+            switch (field.item_size) {
+            case 1: return is_signed ? set_codec<int_bits<int8_t>>(packed) : set_codec<int_bits<uint8_t>>(packed);
+            case 2: return is_signed ? set_codec<int_bits<int16_t>>(packed) : set_codec<int_bits<uint16_t>>(packed);
+            case 4: return is_signed ? set_codec<int_bits<int32_t>>(packed) : set_codec<int_bits<uint32_t>>(packed);
+            case 8: return is_signed ? set_codec<int_bits<int64_t>>(packed) : set_codec<int_bits<uint64_t>>(packed);
+            }
+        }
+        throw not_implemented(__FUNCTION__);
+    }
+
+    // the least value and the bits of an integer field
+    void set_width(packed_field& packed, const schema_field& field)
+    {
+        uint32_t full = uint32_t(field.item_size * 8);
+        if (field.item_kind == value_kind::FLOAT) {
+            packed.min = 0;
+            packed.range = low_mask(full);
+            packed.bits = full;
+            return;
+        }
+
+        // declared values, intersected
+        bool bounded = false;
+        int64_t lo = std::numeric_limits<int64_t>::min();
+        int64_t hi = std::numeric_limits<int64_t>::max();
+        auto bound = [&](int64_t min, int64_t max) {
+            lo = std::max(lo, min);
+            hi = std::min(hi, max);
+            bounded = true;
+        };
+
+        if (field.flags & IS_BOOL)
+            bound(0, 1);
+        if (field.item_kind == value_kind::ENUM && field.options.size() != 0) {
+            auto range = std::minmax_element(field.options.begin(), field.options.end(),
+                [](const enum_option& a, const enum_option& b) { return a.value < b.value; });
+            bound(range.first->value, range.second->value);
+        }
+        if ((field.flags & HAS_ONE_OF) && field.one_of.size() != 0) {
+            auto range = std::minmax_element(field.one_of.begin(), field.one_of.end());
+            bound(*range.first, *range.second);
+        }
+        if (field.flags & HAS_RANGE)
+            bound(field.int_min, field.int_max);
+
+        if (bounded && lo <= hi) {
+            uint32_t bits = bits_for(uint64_t(hi) - uint64_t(lo));
+            if (bits < full) {
+                packed.min = lo;
+                packed.range = uint64_t(hi) - uint64_t(lo);
+                packed.bits = bits;
+                return;
+            }
+        }
+
+        // the whole range of the type
+        if (!field.is_signed)
+            packed.min = 0;
+        else if (full < 64)
+            packed.min = -(int64_t(1) << (full - 1));
+        else
+            packed.min = std::numeric_limits<int64_t>::min();
+        packed.range = low_mask(full);
+        packed.bits = full;
+    }
+}
+
+packed_codec::packed_codec(const schema& schema) :
+    m_schema(&schema)
+{
+    for_each_flat(schema, true, [this](const flat_field& field) {
+        add_field(*field.field, field.offset, field.path);
+    });
+}
+
+void packed_codec::add_field(const schema_field& field, ptrdiff_t offset, const std::string& path)
+{
+    auto kind = field.item_kind;
+    if (field.kind == value_kind::VECTOR ||
+        (kind != value_kind::INT && kind != value_kind::ENUM && kind != value_kind::FLOAT))
+        throw not_implemented("packing of non-scalar values");
+
+    packed_field packed = {};
+    packed.path = path;
+    packed.field = &field;
+    packed.offset = offset;
+    packed.bit = m_bits;
+    set_width(packed, field);
+    set_codec(packed, field);
+    m_bits += packed.bits;
+    m_fields.push_back(packed);
+}
+
+size_t packed_codec::index_of(const char *path) const
+{
+    for (size_t i = 0; i < m_fields.size(); i++) {
+        if (m_fields[i].path == path)
+            return i;
+    }
+    throw bad_key_error(path, m_schema->name());
+}
+
+void packed_codec::pack(const void *record, uint64_t *stream, size_t index) const
+{
+    auto *base = static_cast<const uint8_t *>(record);
+    for (auto& field : m_fields) {
+        clear_bits(stream, index * m_bits + field.bit, field.bits);
+        if (field.pack(field, base, 1, 0, stream, index, m_bits))
+            throw bad_value_error(field.path.c_str());
+    }
+}
+
+void packed_codec::unpack(const uint64_t *stream, size_t index, void *record) const
+{
+    auto *base = static_cast<uint8_t *>(record);
+    for (auto& field : m_fields)
+        field.unpack(field, stream, index, m_bits, base, 1, 0);
+}
+
+void packed_codec::pack(const void *records, size_t count, size_t stride, uint64_t *stream) const
+{
+    std::fill(stream, stream + words(count), 0);
+
+    // field by field: one tight loop over all the records
+    auto *base = static_cast<const uint8_t *>(records);
+    for (auto& field : m_fields) {
+        if (field.pack(field, base, count, stride, stream, 0, m_bits))
+            throw bad_value_error(field.path.c_str());
+    }
+}
+
+void packed_codec::unpack(const uint64_t *stream, size_t count, void *records, size_t stride) const
+{
+    auto *base = static_cast<uint8_t *>(records);
+    for (auto& field : m_fields)
+        field.unpack(field, stream, 0, m_bits, base, count, stride);
+}
+
+int64_t packed_codec::get_int(const uint64_t *stream, size_t index, size_t field) const
+{
+    auto& packed = m_fields[field];
+    if (packed.field->item_kind == value_kind::FLOAT)
+        return int64_t(get_float(stream, index, field));
+    uint64_t bits = read_bits(stream, index * m_bits + packed.bit, packed.bits);
+    if (packed.field->flags & IS_BOOL)
+        return bits != 0;
+    return int64_t(bits + uint64_t(packed.min));
+}
+
+void packed_codec::set_int(uint64_t *stream, size_t index, size_t field, int64_t value) const
+{
+    auto& packed = m_fields[field];
+    if (packed.field->item_kind == value_kind::FLOAT)
+        return set_float(stream, index, field, double(value));
+    if (packed.field->flags & IS_BOOL)
+        value = value != 0;
+
+    uint64_t bits = uint64_t(value) - uint64_t(packed.min);
+    if (bits > packed.range)
+        throw bad_value_error(packed.path.c_str());
+    size_t pos = index * m_bits + packed.bit;
+    clear_bits(stream, pos, packed.bits);
+    or_bits(stream, pos, bits, packed.bits);
+}
+
+double packed_codec::get_float(const uint64_t *stream, size_t index, size_t field) const
+{
+    auto& packed = m_fields[field];
+    if (packed.field->item_kind != value_kind::FLOAT)
+        return double(get_int(stream, index, field));
+
+    uint64_t bits = read_bits(stream, index * m_bits + packed.bit, packed.bits);
+    if (packed.bits == 32) {
+        float value;
+        uint32_t raw = uint32_t(bits);
+        memcpy(&value, &raw, sizeof(value));
+        return value;
+    }
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void packed_codec::set_float(uint64_t *stream, size_t index, size_t field, double value) const
+{
+    auto& packed = m_fields[field];
+    if (packed.field->item_kind != value_kind::FLOAT)
+        return set_int(stream, index, field, int64_t(value));
+
+    uint64_t bits;
+    if (packed.bits == 32) {
+        float narrow = float(value);
+        uint32_t raw;
+        memcpy(&raw, &narrow, sizeof(raw));
+        bits = raw;
+    }
+    else
+        memcpy(&bits, &value, sizeof(bits));
+    size_t pos = index * m_bits + packed.bit;
+    clear_bits(stream, pos, packed.bits);
+    or_bits(stream, pos, bits, packed.bits);
+}
+
+INTROSPECT_NS_CLOSE;
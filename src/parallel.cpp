@@ -0,0 +1,71 @@
+#include "introspect/parallel.h"
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+bool task_source::next(size_t& task)
+{
+    // own range first, then the others in round-robin order
+    for (size_t i = 0; i < m_count; i++) {
+        auto& r = m_ranges[m_victim];
+        if (r.next.load(std::memory_order_relaxed) < r.end) {
+            task = r.next.fetch_add(1, std::memory_order_relaxed);
+            if (task < r.end)
+                return true;
+        }
+        m_victim = (m_victim + 1) % m_count;
+    }
+    return false;
+}
+
+void parallel_run(size_t count, size_t threads, const std::function<void(task_source&)>& worker)
+{
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min(threads, count));
+
+    // new of over-aligned types is C++17, the ranges are aligned here
+    using range = task_source::range;
+    size_t space = (threads + 1) * sizeof(range);
+    std::unique_ptr<char[]> memory(new char[space]);
+    void *start = memory.get();
+    auto *ranges = static_cast<range *>(std::align(alignof(range), threads * sizeof(range), start, space));
+    for (size_t i = 0; i < threads; i++) {
+        new (&ranges[i]) range;
+        ranges[i].next = count * i / threads;
+        ranges[i].end = count * (i + 1) / threads;
+    }
+
+    std::exception_ptr error;
+    std::mutex error_lock;
+
+    auto run = [&](size_t i) {
+        try {
+            task_source tasks(ranges, threads, i);
+            worker(tasks);
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(error_lock);
+            if (!error)
+                error = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (size_t i = 1; i < threads; i++)
+        pool.emplace_back(run, i);
+    run(0);
+    for (auto& thread : pool)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+INTROSPECT_NS_CLOSE;
@@ -0,0 +1,140 @@
+#include "introspect/path.h"
+#include "introspect/errors.h"
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+INTROSPECT_NS_OPEN;
+
+namespace
+{
+    template<typename T>
+    struct convert
+    {
+        static int64_t load_int(const void *value) { return int64_t(*static_cast<const T *>(value)); }
+        static void store_int(void *value, int64_t x) { *static_cast<T *>(value) = static_cast<T>(x); }
+        static double load_float(const void *value) { return double(*static_cast<const T *>(value)); }
+        static void store_float(void *value, double x) { *static_cast<T *>(value) = static_cast<T>(x); }
+    };
+
+    template<typename T>
+    void set_convert(path_accessor& access)
+    {
+        access.load_int = &convert<T>::load_int;
+        access.store_int = &convert<T>::store_int;
+        access.load_float = &convert<T>::load_float;
+        access.store_float = &convert<T>::store_float;
+    }
+
+    void set_convert(path_accessor& access, const schema_field& field)
+    {
+        if (field.item_kind == value_kind::FLOAT) {
+            switch (field.item_size) {
+            case sizeof(float): return set_convert<float>(access);
+            case sizeof(double): return set_convert<double>(access);
+            }
+        }
+        else if (field.flags & IS_BOOL)
+            return set_convert<bool>(access);
+        else {
+            bool is_signed = field.is_signed;
+            switch (field.item_size) {
+            case 1: return is_signed ? set_convert<int8_t>(access) : set_convert<uint8_t>(access);
+            case 2: return is_signed ? set_convert<int16_t>(access) : set_convert<uint16_t>(access);
+            case 4: return is_signed ? set_convert<int32_t>(access) : set_convert<uint32_t>(access);
+            case 8: return is_signed ? set_convert<int64_t>(access) : set_convert<uint64_t>(access);
+            }
+        }
+        throw not_implemented(__FUNCTION__);
+    }
+
+    path_accessor resolve(const schema& root, const char *path)
+    {
+        std::string name;
+        const schema *node = &root;
+        ptrdiff_t offset = 0;
+        const char *pos = path;
+        while (true) {
+            size_t len = strcspn(pos, ".[");
+            name.assign(pos, len);
+            auto& field = node->at(name.c_str());
+            offset += field.offset;
+            pos += len;
+
+            auto kind = field.kind;
+            if (*pos == '[') {
+                if (kind == value_kind::VECTOR)
+                    throw not_implemented("paths into std::vector");
+                if (kind != value_kind::ARRAY)
+                    throw bad_key_error(pos, field.name);
+
+                char *end;
+                auto index = strtol(pos + 1, &end, 10);
+                if (end == pos + 1 || *end != ']')
+                    throw bad_key_error(pos, field.name);
+                if (index < 0 || size_t(index) >= field.count)
+                    throw bad_idx_error(index, field.count);
+
+                offset += index * field.item_size;
+                kind = field.item_kind;
+                pos = end + 1;
+            }
+
+            if (*pos == '.') {
+                if (kind != value_kind::STRUCT)
+                    throw bad_key_error(pos + 1, field.name);
+                node = field.nested;
+                pos++;
+                continue;
+            }
+
+            if (*pos != 0)
+                throw bad_key_error(pos, field.name);
+            if (kind != value_kind::INT && kind != value_kind::ENUM && kind != value_kind::FLOAT)
+                throw not_implemented("accessors of non-scalar values");
+
+            path_accessor access = {};
+            access.field = &field;
+            access.offset = offset;
+            access.kind = kind;
+            set_convert(access, field);
+            return access;
+        }
+    }
+
+    using path_cache = std::unordered_map<std::string, path_accessor>;
+
+    // by generation of the schema: dynamic schemas come and go
+    struct path_caches
+    {
+        std::mutex lock;
+        std::unordered_map<uint64_t, path_cache> caches;
+    };
+
+    path_caches& caches()
+    {
+        static path_caches instance;
+        return instance;
+    }
+}
+
+const path_accessor& compile_path(const schema& schema, const char *path)
+{
+    auto& c = caches();
+    std::lock_guard<std::mutex> guard(c.lock);
+    auto& cache = c.caches[schema.generation()];
+    auto i = cache.find(path);
+    if (i == cache.end())
+        i = cache.emplace(path, resolve(schema, path)).first;
+    return i->second;
+}
+
+void forget_paths(const schema& schema)
+{
+    auto& c = caches();
+    std::lock_guard<std::mutex> guard(c.lock);
+    c.caches.erase(schema.generation());
+}
+
+INTROSPECT_NS_CLOSE;
@@ -0,0 +1,178 @@
+#include "introspect/profile.h"
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+
+INTROSPECT_NS_OPEN;
+
+#ifdef INTROSPECT_PROFILE
+
+namespace
+{
+    static const size_t MAX_HEAT_SLOTS = 4096;
+
+    // written by the owner thread only, so relaxed load and store are enough
+    struct thread_heat
+    {
+        thread_heat();
+        ~thread_heat();
+
+        void count(size_t slot) {
+            auto& counter = counters[slot];
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        std::unique_ptr<std::atomic<uint64_t>[]> counters;
+    };
+
+    struct heat_registry
+    {
+        std::mutex lock;
+        std::vector<heat_entry> slots;
+        std::map<std::pair<std::string, std::string>, size_t> index;
+        bool overflow = false;  // fields past MAX_HEAT_SLOTS are not counted
+        std::set<thread_heat *> threads;
+        std::vector<uint64_t> retired; // counts of finished threads
+    };
+
+    heat_registry& registry()
+    {
+        static heat_registry instance;
+        return instance;
+    }
+
+    thread_heat::thread_heat() :
+        counters(new std::atomic<uint64_t>[MAX_HEAT_SLOTS])
+    {
+        for (size_t i = 0; i < MAX_HEAT_SLOTS; i++)
+            counters[i].store(0, std::memory_order_relaxed);
+
+        auto& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        r.threads.insert(this);
+    }
+
+    thread_heat::~thread_heat()
+    {
+        auto& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        r.threads.erase(this);
+        r.retired.resize(MAX_HEAT_SLOTS);
+        for (size_t i = 0; i < MAX_HEAT_SLOTS; i++)
+            r.retired[i] += counters[i].load(std::memory_order_relaxed);
+    }
+
+    thread_local thread_heat t_heat;
+}
+
+size_t heat_slot(const char *root, const char *path, ptrdiff_t offset, size_t size)
+{
+    auto& r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    auto key = std::make_pair(std::string(root), std::string(path));
+    auto i = r.index.find(key);
+    if (i != r.index.end())
+        return i->second;
+
+    if (r.slots.size() >= MAX_HEAT_SLOTS) {
+        r.overflow = true;
+        return size_t(-1);
+    }
+    size_t slot = r.slots.size();
+    r.slots.push_back({ root, path, offset, size, 0 });
+    r.index.emplace(std::move(key), slot);
+    return slot;
+}
+
+void struct_mirror::assign_heat(const char *root, const std::string& prefix, ptrdiff_t offset)
+{
+    heat_assigned = true;
+    for (auto& field : fields()) {
+        auto path = prefix + field.name();
+        auto at = offset + field.offset;
+        field.heat_slot = heat_slot(root, path.c_str(), at, field.size());
+        if (auto *nested = mirror_cast<struct_mirror>(&field))
+            nested->assign_heat(root, path + ".", at);
+        else if (auto *array = mirror_cast<struct_array_mirror>(&field)) {
+            // the shared element mirror, at the offset of the first element
+            if (array->count())
+                array->element(0).assign_heat(root, path + "[].", at);
+        }
+    }
+}
+
+void base_field::touched() const
+{
+    if (heat_slot != size_t(-1))
+        t_heat.count(heat_slot);
+}
+
+std::vector<heat_entry> heat_report()
+{
+    auto& r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+
+    auto report = r.slots;
+    for (size_t i = 0; i < report.size() && i < MAX_HEAT_SLOTS; i++) {
+        uint64_t count = i < r.retired.size() ? r.retired[i] : 0;
+        for (auto *thread : r.threads)
+            count += thread->counters[i].load(std::memory_order_relaxed);
+        report[i].count = count;
+    }
+
+    std::stable_sort(report.begin(), report.end(),
+        [](const heat_entry& a, const heat_entry& b) { return a.count > b.count; });
+    return report;
+}
+
+bool heat_overflow()
+{
+    auto& r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    return r.overflow;
+}
+
+void reset_heat()
+{
+    auto& r = registry();
+    std::lock_guard<std::mutex> guard(r.lock);
+    r.retired.clear();
+    for (auto *thread : r.threads) {
+        for (size_t i = 0; i < MAX_HEAT_SLOTS; i++)
+            thread->counters[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+#else
+
+std::vector<heat_entry> heat_report()
+{
+    return{};
+}
+
+bool heat_overflow()
+{
+    return false;
+}
+
+void reset_heat()
+{
+}
+
+#endif
+
+std::ostream& operator<<(std::ostream& out, const std::vector<heat_entry>& report)
+{
+    out << "     count  offset   size  field\n";
+    for (auto& entry : report) {
+        out << std::setw(10) << entry.count << std::setw(8) << entry.offset << std::setw(7) << entry.size
+            << "  " << entry.type << "::" << entry.name << "\n";
+    }
+    return out;
+}
+
+INTROSPECT_NS_CLOSE;
@@ -0,0 +1,106 @@
+#include "introspect/prometheus.h"
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+INTROSPECT_NS_OPEN;
+
+namespace
+{
+    // metric names are [a-zA-Z_:][a-zA-Z0-9_:]*
+    std::string metric_name(const char *name)
+    {
+        std::string result(name);
+        for (auto& c : result) {
+            if (!isalnum(static_cast<unsigned char>(c)) && c != ':')
+                c = '_';
+        }
+        return result;
+    }
+
+    bool is_scalar(mirror_kind kind)
+    {
+        return kind == mirror_kind::INT || kind == mirror_kind::ENUM || kind == mirror_kind::FLOAT;
+    }
+
+    void append_int(std::string& out, int64_t value)
+    {
+        char buffer[24];
+        char *end = buffer + sizeof(buffer), *pos = end;
+        uint64_t n = value < 0 ? 0 - uint64_t(value) : uint64_t(value);
+        do {
+            *--pos = char('0' + n % 10);
+            n /= 10;
+        } while (n);
+        if (value < 0)
+            *--pos = '-';
+        out.append(pos, end);
+    }
+
+    void append_float(std::string& out, double value)
+    {
+        if (std::isnan(value))
+            out += "NaN";
+        else if (std::isinf(value))
+            out += value > 0 ? "+Inf" : "-Inf";
+        else {
+            // 15 digits if they read back exactly, 17 otherwise
+            char buffer[32];
+            int len = snprintf(buffer, sizeof(buffer), "%.15g", value);
+            if (strtod(buffer, nullptr) != value)
+                len = snprintf(buffer, sizeof(buffer), "%.17g", value);
+            out.append(buffer, len);
+        }
+    }
+
+    void append_value(std::string& out, const base_mirror& value)
+    {
+        if (auto *number = mirror_cast<float_mirror>(&value))
+            append_float(out, number->float_value());
+        else
+            append_int(out, mirror_cast<int_mirror>(&value)->int_value());
+    }
+}
+
+prometheus_exporter::prometheus_exporter(const struct_mirror& stats, const char *prefix)
+{
+    std::string name = metric_name(prefix);
+    add_metrics(stats, name.empty() ? name : name + "_");
+}
+
+void prometheus_exporter::add_metrics(const struct_mirror& value, const std::string& prefix)
+{
+    for (auto& field : value.fields()) {
+        auto name = prefix + metric_name(field.name());
+        auto kind = field.kind();
+        if (is_scalar(kind))
+            m_metrics.push_back({ name + " ", &field, NO_INDEX });
+        else if (kind == mirror_kind::STRUCT)
+            add_metrics(*mirror_cast<struct_mirror>(&field), name + "_");
+        else if (kind == mirror_kind::ARRAY) {
+            auto *array = mirror_cast<array_mirror>(&field);
+            size_t count = array->count();
+            if (count == 0 || !is_scalar((*array)[0].kind()))
+                continue;
+            for (size_t i = 0; i < count; i++)
+                m_metrics.push_back({ name + "{index=\"" + std::to_string(i) + "\"} ", &field, i });
+        }
+    }
+}
+
+const std::string& prometheus_exporter::scrape()
+{
+    m_buffer.clear();
+    for (auto& metric : m_metrics) {
+        m_buffer += metric.name;
+        if (metric.index == NO_INDEX)
+            append_value(m_buffer, *metric.value);
+        else
+            append_value(m_buffer, (*mirror_cast<array_mirror>(metric.value))[metric.index]);
+        m_buffer += '\n';
+    }
+    return m_buffer;
+}
+
+INTROSPECT_NS_CLOSE;
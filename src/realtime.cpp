@@ -0,0 +1,381 @@
+#include "introspect/realtime.h"
+#include "introspect/errors.h"
+#include "introspect/io.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+INTROSPECT_NS_OPEN;
+
+namespace
+{
+    // values longer than that are not numbers nor enum options
+    constexpr size_t MAX_VALUE_LENGTH = 64;
+
+    bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    bool parse_int(const char *text, int64_t& value)
+    {
+        const char *digits = text + (*text == '-' || *text == '+');
+        bool hex = digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X');
+        char *end;
+        errno = 0;
+        value = strtoll(text, &end, hex ? 16 : 10);
+        return end != text && *end == 0 && errno != ERANGE;
+    }
+
+    bool parse_float(const char *text, double& value)
+    {
+        char *end;
+        errno = 0;
+        value = strtod(text, &end);
+        return end != text && *end == 0 && errno != ERANGE;
+    }
+
+    // the value fits into the type of the field
+    bool in_range(const schema_field& field, int64_t value)
+    {
+        if (field.flags & IS_BOOL)
+            return value == 0 || value == 1;
+        if (field.item_size >= 8)
+            return field.is_signed || value >= 0;
+        uint32_t bits = 8 * field.item_size;
+        if (field.is_signed)
+            return value >= -(int64_t(1) << (bits - 1)) && value < int64_t(1) << (bits - 1);
+        return value >= 0 && value < int64_t(1) << bits;
+    }
+
+    // elements of the scalar array in the entry, 1 for scalars
+    size_t item_count(const path_accessor& access)
+    {
+        return access.field->kind == value_kind::ARRAY ? access.field->count : 1;
+    }
+
+    // base shifted to the element i of the array, the scalar itself is element 0
+    const void *item_base(const path_accessor& access, const void *base, size_t i)
+    {
+        return static_cast<const uint8_t *>(base) + i * access.field->item_size;
+    }
+
+    void *item_base(const path_accessor& access, void *base, size_t i)
+    {
+        return static_cast<uint8_t *>(base) + i * access.field->item_size;
+    }
+
+    // the value is parsed, and assigned unless base is nullptr
+    rt_status apply_value(const path_accessor& access, void *base, const char *text)
+    {
+        auto& field = *access.field;
+        int64_t int_value;
+        double float_value;
+
+        switch (access.kind) {
+        case value_kind::ENUM:
+            for (auto& option : field.options) {
+                if (0 == strcmp(option.name, text)) {
+                    if (base)
+                        access.set_int(base, option.value);
+                    return rt_status::OK;
+                }
+            }
+            // options by number as well
+        case value_kind::INT:
+            if (!parse_int(text, int_value) || !in_range(field, int_value))
+                return rt_status::BAD_VALUE;
+            if (base)
+                access.set_int(base, int_value);
+            return rt_status::OK;
+        case value_kind::FLOAT:
+            if (!parse_float(text, float_value))
+                return rt_status::BAD_VALUE;
+            if (base)
+                access.set_float(base, float_value);
+            return rt_status::OK;
+        default:
+            return rt_status::BAD_VALUE;
+        }
+    }
+
+    // "1, 2, 3" of the array, or the only value of the scalar; the values are
+    // checked before the first one is assigned, so a bad one leaves all as they are
+    rt_status apply_items(const path_accessor& access, void *base, const char *pos, const char *end)
+    {
+        size_t count = item_count(access);
+        for (void *target : { static_cast<void *>(nullptr), base }) {
+            const char *item = pos;
+            size_t i = 0;
+            while (true) {
+                auto *comma = static_cast<const char *>(memchr(item, ',', end - item));
+                const char *next = comma ? comma : end;
+                while (item < next && is_blank(*item))
+                    item++;
+                const char *last = next;
+                while (last > item && is_blank(last[-1]))
+                    last--;
+                if (item == last)
+                    return rt_status::SYNTAX_ERROR;
+                if (i == count)
+                    return rt_status::BAD_VALUE;
+
+                // the number parsers need terminated text
+                char value[MAX_VALUE_LENGTH];
+                size_t value_length = last - item;
+                if (value_length >= sizeof(value))
+                    return rt_status::BAD_VALUE;
+                memcpy(value, item, value_length);
+                value[value_length] = 0;
+
+                auto status = apply_value(access, target ? item_base(access, target, i) : nullptr, value);
+                if (status != rt_status::OK)
+                    return status;
+                i++;
+                if (!comma)
+                    break;
+                item = comma + 1;
+            }
+
+            // fillers are not in the schema, so all elements are given
+            if (i != count)
+                return rt_status::BAD_VALUE;
+        }
+        return rt_status::OK;
+    }
+
+    // adds the printed length, false if the text doesn't fit
+    bool advance(size_t& length, int printed, size_t size)
+    {
+        if (printed < 0 || length + size_t(printed) >= size)
+            return false;
+        length += size_t(printed);
+        return true;
+    }
+
+    // the shortest of %g that reads back the same value of the type
+    // the field named last in the path, X of "pts[1].X"; indexed if the path ends with "[i]";
+    // the rest of the path is checked by compile_path
+    const schema_field& last_field(const schema& root, const char *path, bool& indexed)
+    {
+        const schema *node = &root;
+        std::string name;
+        while (true) {
+            size_t length = strcspn(path, ".[");
+            name.assign(path, length);
+            auto& field = node->at(name.c_str());
+            path += length;
+            indexed = *path == '[';
+            if (indexed) {
+                path += strcspn(path, "]");
+                path += *path == ']';
+            }
+            if (*path != '.' || !field.nested)
+                return field;
+            node = field.nested;
+            path++;
+        }
+    }
+
+    int print_value(const path_accessor& access, const void *base, char *buffer, size_t size)
+    {
+        auto& field = *access.field;
+        if (access.kind == value_kind::FLOAT)
+            return print_float(buffer, size, access.get_float(base), field.item_size == sizeof(float));
+
+        auto value = access.get_int(base);
+        if (access.kind == value_kind::ENUM) {
+            for (auto& option : field.options) {
+                if (option.value == value)
+                    return snprintf(buffer, size, "%s", option.name);
+            }
+        }
+        if (field.is_signed)
+            return snprintf(buffer, size, "%lld", static_cast<long long>(value));
+        return snprintf(buffer, size, "%llu", static_cast<unsigned long long>(value));
+    }
+}
+
+const char *rt_status_name(rt_status status) noexcept
+{
+    switch (status) {
+    case rt_status::OK:             return "OK";
+    case rt_status::SYNTAX_ERROR:   return "SYNTAX_ERROR";
+    case rt_status::UNKNOWN_PATH:   return "UNKNOWN_PATH";
+    case rt_status::BAD_VALUE:      return "BAD_VALUE";
+    case rt_status::BUFFER_FULL:    return "BUFFER_FULL";
+    }
+    return "UNKNOWN";
+}
+
+//
+// rt_table
+//
+
+rt_table::rt_table(const schema& schema)
+{
+    for_each_flat(schema, false, [&](const flat_field& field) {
+        auto& value = *field.field;
+        if (value.kind == value_kind::ARRAY ? value.item_kind != value_kind::STRING : value.is_scalar())
+            add(schema, field.path.c_str());
+    });
+    sort();
+}
+
+rt_table::rt_table(const schema& schema, std::initializer_list<const char *> paths)
+{
+    for (auto *path : paths)
+        add(schema, path);
+    sort();
+}
+
+void rt_table::add(const schema& schema, const char *path)
+{
+    bool indexed;
+    auto& field = last_field(schema, path, indexed);
+
+    // the text format has no paths of scalar elements
+    if (indexed)
+        throw bad_key_error(path, "rt_table");
+
+    // a scalar array is one entry, as in the text format: "a = { 1, 2, 3 }";
+    // it is accessed by its first element
+    if (field.kind == value_kind::ARRAY)
+        m_entries.push_back({ path, &compile_path(schema, (std::string(path) + "[0]").c_str()) });
+    else
+        m_entries.push_back({ path, &compile_path(schema, path) });
+}
+
+void rt_table::sort()
+{
+    m_sorted.resize(m_entries.size());
+    for (size_t i = 0; i < m_sorted.size(); i++)
+        m_sorted[i] = i;
+    std::sort(m_sorted.begin(), m_sorted.end(), [this](size_t a, size_t b) {
+        return m_entries[a].path < m_entries[b].path;
+    });
+}
+
+const path_accessor *rt_table::find(const char *path, size_t length) const noexcept
+{
+    auto i = std::lower_bound(m_sorted.begin(), m_sorted.end(), path, [&](size_t e, const char *) {
+        return m_entries[e].path.compare(0, std::string::npos, path, length) < 0;
+    });
+    if (i == m_sorted.end() || m_entries[*i].path.compare(0, std::string::npos, path, length) != 0)
+        return nullptr;
+    return m_entries[*i].access;
+}
+
+//
+// apply
+//
+
+rt_status rt_apply(const rt_table& table, void *base, const char *line, size_t length) noexcept
+{
+    const char *pos = line, *end = line + length;
+    while (pos < end && is_blank(*pos))
+        pos++;
+    while (end > pos && is_blank(end[-1]))
+        end--;
+
+    const char *path = pos;
+    while (pos < end && !is_blank(*pos) && *pos != '=')
+        pos++;
+    size_t path_length = pos - path;
+    while (pos < end && is_blank(*pos))
+        pos++;
+    if (!path_length || pos == end || *pos != '=')
+        return rt_status::SYNTAX_ERROR;
+    pos++;
+    while (pos < end && is_blank(*pos))
+        pos++;
+    if (pos == end)
+        return rt_status::SYNTAX_ERROR;
+
+    auto *access = table.find(path, path_length);
+    if (!access)
+        return rt_status::UNKNOWN_PATH;
+
+    // braces of arrays are optional, as for the parser
+    if (*pos == '{' && access->field->kind == value_kind::ARRAY) {
+        if (end - pos < 2 || end[-1] != '}')
+            return rt_status::SYNTAX_ERROR;
+        pos++;
+        end--;
+    }
+    return apply_items(*access, base, pos, end);
+}
+
+rt_status rt_apply_delta(const rt_table& table, void *base, const char *text, size_t size, size_t *applied) noexcept
+{
+    rt_status first = rt_status::OK;
+    size_t count = 0;
+    const char *pos = text, *end = text + size;
+    while (pos < end) {
+        auto *eol = static_cast<const char *>(memchr(pos, '\n', end - pos));
+        if (!eol)
+            eol = end;
+        const char *beg = pos;
+        while (beg < eol && is_blank(*beg))
+            beg++;
+        if (beg != eol) {
+            auto status = rt_apply(table, base, beg, eol - beg);
+            if (status == rt_status::OK)
+                count++;
+            else if (first == rt_status::OK)
+                first = status;
+        }
+        pos = eol + 1;
+    }
+    if (applied)
+        *applied = count;
+    return first;
+}
+
+//
+// print
+//
+
+rt_status rt_print(const rt_table& table, size_t i, const void *base, char *buffer, size_t size, size_t *written) noexcept
+{
+    *written = 0;
+    auto& access = table.accessor(i);
+    size_t length = 0;
+    bool fits = advance(length, snprintf(buffer, size, "%s = ", table.path(i)), size);
+    if (access.field->kind == value_kind::ARRAY) {
+        // "{ 1, 2, 3 }" as the printer does
+        fits = fits && advance(length, snprintf(buffer + length, size - length, "{"), size);
+        for (size_t k = 0, n = item_count(access); fits && k < n; k++) {
+            fits = advance(length, snprintf(buffer + length, size - length, k ? ", " : " "), size) &&
+                advance(length, print_value(access, item_base(access, base, k), buffer + length, size - length), size);
+        }
+        fits = fits && advance(length, snprintf(buffer + length, size - length, " }"), size);
+    }
+    else
+        fits = fits && advance(length, print_value(access, base, buffer + length, size - length), size);
+    if (!fits || length + 1 >= size)
+        return rt_status::BUFFER_FULL;
+    buffer[length++] = '\n';
+    buffer[length] = 0;
+    *written = length;
+    return rt_status::OK;
+}
+
+rt_status rt_print(const rt_table& table, const void *base, char *buffer, size_t size, size_t *written) noexcept
+{
+    size_t total = 0;
+    for (size_t i = 0; i < table.count(); i++) {
+        size_t length;
+        auto status = rt_print(table, i, base, buffer + total, size - total, &length);
+        if (status != rt_status::OK) {
+            if (total < size)
+                buffer[total] = 0;
+            *written = total;
+            return status;
+        }
+        total += length;
+    }
+    *written = total;
+    return rt_status::OK;
+}
+
+INTROSPECT_NS_CLOSE;
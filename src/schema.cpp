@@ -0,0 +1,284 @@
+#include "introspect/schema.h"
+#include "introspect/io.h"
+#include "introspect/errors.h"
+#include <atomic>
+#include <cstring>
+#include <string>
+
+INTROSPECT_NS_OPEN;
+
+//
+// schema
+//
+
+void describe_type<std::string>::fill(schema_field& field)
+{
+    field.kind = value_kind::STRING;
+    static const container_ops ops = {
+        [](const void *value) { return static_cast<const std::string *>(value)->size(); },
+        [](void *value) -> void * { return &(*static_cast<std::string *>(value))[0]; },
+        [](void *value, size_t count) { static_cast<std::string *>(value)->resize(count); },
+    };
+    field.ops = &ops;
+}
+
+uint64_t schema::next_generation()
+{
+    static std::atomic<uint64_t> counter(0);
+    return ++counter;
+}
+
+namespace
+{
+    void flatten(const schema& schema, bool elements, flat_field& node, const std::function<void(const flat_field&)>& fn)
+    {
+        auto prefix = node.path.size();
+        auto offset = node.offset;
+        for (auto& field : schema) {
+            node.path.resize(prefix);
+            node.path += field.name;
+            node.field = &field;
+            node.offset = offset + field.offset;
+            if (field.kind == value_kind::STRUCT) {
+                node.path += ".";
+                flatten(*field.nested, elements, node, fn);
+            }
+            else if (field.kind == value_kind::ARRAY && (field.item_kind == value_kind::STRUCT || elements)) {
+                auto name = node.path.size();
+                auto base = node.offset;
+                for (size_t i = 0; i < field.count; i++) {
+                    node.path.resize(name);
+                    node.path += "[" + std::to_string(i) + "]";
+                    node.field = &field;
+                    node.offset = base + i * field.item_size;
+                    if (field.item_kind != value_kind::STRUCT)
+                        fn(node);
+                    else {
+                        node.path += ".";
+                        flatten(*field.nested, elements, node, fn);
+                    }
+                }
+            }
+            else
+                fn(node);
+        }
+    }
+}
+
+void for_each_flat(const schema& schema, bool elements, const std::function<void(const flat_field&)>& fn)
+{
+    flat_field node = { "", nullptr, 0 };
+    flatten(schema, elements, node, fn);
+}
+
+const schema_field *schema::find(const char *name) const
+{
+    for (auto& field : *this) {
+        if (0 == strcmp(field.name, name))
+            return &field;
+    }
+    return nullptr;
+}
+
+const schema_field& schema::at(const char *name) const
+{
+    auto *field = find(name);
+    if (!field)
+        throw bad_key_error(name, m_name);
+    return *field;
+}
+
+//
+// field_view
+//
+
+int64_t field_view::int_value() const
+{
+    if (kind() == value_kind::FLOAT)
+        return int64_t(float_value());
+
+    bool is_signed = m_field->is_signed;
+    switch (m_field->item_size) {
+    case 1: return is_signed ? int64_t(*reinterpret_cast<int8_t *>(m_addr)) : int64_t(*m_addr);
+    case 2: return is_signed ? int64_t(*reinterpret_cast<int16_t *>(m_addr)) : int64_t(*reinterpret_cast<uint16_t *>(m_addr));
+    case 4: return is_signed ? int64_t(*reinterpret_cast<int32_t *>(m_addr)) : int64_t(*reinterpret_cast<uint32_t *>(m_addr));
+    case 8: return *reinterpret_cast<int64_t *>(m_addr);
+    }
+    throw not_implemented(__FUNCTION__);
+}
+
+void field_view::int_value(int64_t value) const
+{
+    if (kind() == value_kind::FLOAT)
+        return float_value(double(value));
+
+    if (m_field->flags & IS_BOOL)
+        value = value != 0;
+
+    switch (m_field->item_size) {
+    case 1: *m_addr = uint8_t(value); return;
+    case 2: *reinterpret_cast<uint16_t *>(m_addr) = uint16_t(value); return;
+    case 4: *reinterpret_cast<uint32_t *>(m_addr) = uint32_t(value); return;
+    case 8: *reinterpret_cast<int64_t *>(m_addr) = value; return;
+    }
+    throw not_implemented(__FUNCTION__);
+}
+
+double field_view::float_value() const
+{
+    if (kind() != value_kind::FLOAT)
+        return double(int_value());
+
+    switch (m_field->item_size) {
+    case sizeof(float): return *reinterpret_cast<float *>(m_addr);
+    case sizeof(double): return *reinterpret_cast<double *>(m_addr);
+    }
+    throw not_implemented(__FUNCTION__);
+}
+
+void field_view::float_value(double value) const
+{
+    if (kind() != value_kind::FLOAT)
+        return int_value(int64_t(value));
+
+    switch (m_field->item_size) {
+    case sizeof(float): *reinterpret_cast<float *>(m_addr) = float(value); return;
+    case sizeof(double): *reinterpret_cast<double *>(m_addr) = value; return;
+    }
+    throw not_implemented(__FUNCTION__);
+}
+
+const char *field_view::str_value() const
+{
+    return static_cast<const char *>(ops()->data(m_addr));
+}
+
+size_t field_view::length() const
+{
+    return ops()->count(m_addr);
+}
+
+base_view field_view::nested() const
+{
+    return{ *m_field->nested, m_addr };
+}
+
+size_t field_view::count() const
+{
+    if (m_field->kind == value_kind::VECTOR)
+        return m_field->ops->count(m_addr);
+    return m_field->count;
+}
+
+field_view field_view::item(size_t i) const
+{
+    size_t len = count();
+    if (i >= len)
+        throw bad_idx_error(i, len);
+
+    auto *data = m_field->kind == value_kind::VECTOR ?
+        static_cast<uint8_t *>(m_field->ops->data(m_addr)) : m_addr;
+    return{ m_field, data + i * m_field->item_size, true };
+}
+
+//
+// base_view
+//
+
+field_view base_view::at_path(const char *path) const
+{
+    std::string name;
+    base_view node = *this;
+    while (true) {
+        auto *dot = strchr(path, '.');
+        name.assign(path, dot ? dot - path : strlen(path));
+        auto field = node.at(name.c_str());
+        if (!dot)
+            return field;
+        if (field.kind() != value_kind::STRUCT)
+            throw bad_key_error(dot + 1, field.name());
+        node = field.nested();
+        path = dot + 1;
+    }
+}
+
+//
+// printer, the same format as print_visitor
+//
+
+namespace
+{
+    void print_item(std::ostream& out, const field_view& value)
+    {
+        switch (value.kind()) {
+        case value_kind::INT:
+            out << value.int_value();
+            break;
+        case value_kind::FLOAT: {
+            char text[32];
+            print_float(text, sizeof(text), value.float_value(), value.field().item_size == sizeof(float));
+            out << text;
+            break;
+        }
+        case value_kind::ENUM: {
+            auto int_value = value.int_value();
+            for (auto& pair : value.field().options) {
+                if (pair.value == int_value) {
+                    out << pair.name;
+                    return;
+                }
+            }
+            out << int_value;
+            break;
+        }
+        case value_kind::STRING:
+            print_string(out, value.str_value(), value.length());
+            break;
+        default:
+            throw not_implemented(__FUNCTION__);
+        }
+    }
+
+    void print_struct(std::ostream& out, const std::string& prefix, const base_view& view);
+
+    void print_field(std::ostream& out, const std::string& path, const field_view& value)
+    {
+        auto kind = value.kind();
+        if (kind == value_kind::STRUCT)
+            return print_struct(out, path + ".", value.nested());
+
+        bool is_array = kind == value_kind::ARRAY || kind == value_kind::VECTOR;
+        if (is_array && value.field().item_kind == value_kind::STRUCT) {
+            for (size_t i = 0, n = value.count(); i < n; i++)
+                print_struct(out, path + "[" + std::to_string(i) + "].", value.item(i).nested());
+            return;
+        }
+
+        out << path << " = ";
+        if (is_array) {
+            out << "{";
+            for (size_t i = 0, n = value.count(); i < n; i++) {
+                out << (i ? ", " : " ");
+                print_item(out, value.item(i));
+            }
+            out << " }";
+        }
+        else
+            print_item(out, value);
+        out << "\n";
+    }
+
+    void print_struct(std::ostream& out, const std::string& prefix, const base_view& view)
+    {
+        for (auto field : view)
+            print_field(out, prefix + field.name(), field);
+    }
+}
+
+std::ostream& operator<<(std::ostream& out, const base_view& view)
+{
+    print_struct(out, "", view);
+    return out;
+}
+
+INTROSPECT_NS_CLOSE;
@@ -0,0 +1,266 @@
+#include "introspect/snapshot.h"
+#include "introspect/errors.h"
+#include "introspect/io.h"
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+
+INTROSPECT_NS_OPEN;
+
+namespace
+{
+    const char MAGIC[4] = { 'I', 'S', 'N', 'P' };
+
+    enum record_tag : uint8_t
+    {
+        DELTA_RECORD,
+        KEYFRAME_RECORD,
+    };
+
+    //
+    // encoding of the values
+    //
+
+    void put_varint(std::string& out, uint64_t value)
+    {
+        while (value >= 0x80) {
+            out.push_back(char(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(char(value));
+    }
+
+    uint64_t get_varint(const uint8_t *& pos, const uint8_t *end)
+    {
+        uint64_t value = 0;
+        for (int shift = 0; pos < end && shift < 64; shift += 7) {
+            uint8_t byte = *pos++;
+            value |= uint64_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        throw parse_error("Truncated snapshot log");
+    }
+
+    uint64_t zigzag(uint64_t delta) { return (delta << 1) ^ uint64_t(int64_t(delta) >> 63); }
+    uint64_t unzigzag(uint64_t value) { return (value >> 1) ^ (0 - (value & 1)); }
+
+    uint32_t trailing_zeros(uint64_t value)
+    {
+        uint32_t bits = 0;
+        while (bits < 64 && !(value >> bits & 1))
+            bits++;
+        return bits;
+    }
+
+    // integers are sign extended, floats are their IEEE bits
+    uint64_t load_bits(const schema_field& field, const uint8_t *value)
+    {
+        uint64_t bits = 0;
+        memcpy(&bits, value, field.item_size);
+        if (field.item_kind != value_kind::FLOAT && field.is_signed && field.item_size < 8) {
+            uint32_t shift = 64 - 8 * field.item_size;
+            bits = uint64_t(int64_t(bits << shift) >> shift);
+        }
+        return bits;
+    }
+
+    void store_bits(const schema_field& field, uint8_t *value, uint64_t bits)
+    {
+        memcpy(value, &bits, field.item_size);
+    }
+
+    // FNV-1a of the paths, kinds and sizes of the fields, kept in the header:
+    // a log is read back only with the schema it was written with
+    uint64_t fingerprint(const std::vector<snapshot_field>& fields)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        auto add = [&](const void *data, size_t size) {
+            for (size_t i = 0; i < size; i++)
+                hash = (hash ^ static_cast<const uint8_t *>(data)[i]) * 1099511628211ull;
+        };
+        for (auto& field : fields) {
+            auto& value = *field.field;
+            add(field.path.c_str(), field.path.size() + 1);
+            uint8_t kinds[] = { uint8_t(value.kind), uint8_t(value.item_kind), uint8_t(value.is_signed) };
+            add(kinds, sizeof(kinds));
+            add(&value.item_size, sizeof(value.item_size));
+        }
+        return hash;
+    }
+}
+
+std::vector<snapshot_field> snapshot_fields(const schema& schema)
+{
+    std::vector<snapshot_field> fields;
+    for_each_flat(schema, true, [&](const flat_field& field) {
+        auto kind = field.field->item_kind;
+        if (field.field->kind == value_kind::VECTOR)
+            throw not_implemented("snapshots of std::vector");
+        if (kind != value_kind::INT && kind != value_kind::ENUM &&
+            kind != value_kind::FLOAT && kind != value_kind::STRING)
+            throw not_implemented("snapshots of non-scalar values");
+        fields.push_back(field);
+    });
+    return fields;
+}
+
+//
+// snapshot_writer
+//
+
+snapshot_writer::snapshot_writer(const schema& schema, std::ostream& out, size_t keyframe_interval) :
+    m_schema(&schema), m_out(&out), m_interval(std::max<size_t>(keyframe_interval, 1)),
+    m_fields(snapshot_fields(schema))
+{
+    m_values.resize(m_fields.size());
+    m_strings.resize(m_fields.size());
+
+    std::string header(MAGIC, sizeof(MAGIC));
+    put_varint(header, m_fields.size());
+    put_varint(header, fingerprint(m_fields));
+    m_out->write(header.data(), header.size());
+}
+
+void snapshot_writer::write(const void *record)
+{
+    // keyframe is the delta against zero values
+    bool keyframe = m_count % m_interval == 0;
+    if (keyframe) {
+        std::fill(m_values.begin(), m_values.end(), 0);
+        for (auto& value : m_strings)
+            value.clear();
+    }
+
+    auto *base = static_cast<const uint8_t *>(record);
+    size_t bitmap = (m_fields.size() + 7) / 8;
+    m_body.assign(bitmap, '\0');
+
+    for (size_t i = 0; i < m_fields.size(); i++) {
+        auto& field = *m_fields[i].field;
+        auto *value = base + m_fields[i].offset;
+
+        if (field.item_kind == value_kind::STRING) {
+            auto& str = *reinterpret_cast<const std::string *>(value);
+            if (!keyframe && str == m_strings[i])
+                continue;
+            put_varint(m_body, str.size());
+            m_body.append(str);
+            m_strings[i] = str;
+        }
+        else {
+            uint64_t bits = load_bits(field, value);
+            uint64_t prev = m_values[i];
+            if (!keyframe && bits == prev)
+                continue;
+            if (field.item_kind == value_kind::FLOAT) {
+                // close values share the sign, exponent and high bits of mantissa
+                uint64_t diff = bits ^ prev;
+                uint32_t zeros = diff ? trailing_zeros(diff) : 0;
+                m_body.push_back(char(zeros));
+                put_varint(m_body, diff >> zeros);
+            }
+            else
+                put_varint(m_body, zigzag(bits - prev));
+            m_values[i] = bits;
+        }
+        m_body[i / 8] |= char(1 << i % 8);
+    }
+
+    std::string head(1, char(keyframe ? KEYFRAME_RECORD : DELTA_RECORD));
+    put_varint(head, m_body.size());
+    m_out->write(head.data(), head.size());
+    m_out->write(m_body.data(), m_body.size());
+    m_count++;
+}
+
+//
+// snapshot_reader
+//
+
+snapshot_reader::snapshot_reader(const schema& schema, const void *data, size_t size) :
+    m_schema(&schema), m_data(static_cast<const uint8_t *>(data)), m_size(size),
+    m_fields(snapshot_fields(schema))
+{
+    const uint8_t *pos = m_data, *end = m_data + m_size;
+    if (m_size < sizeof(MAGIC) || memcmp(pos, MAGIC, sizeof(MAGIC)) != 0)
+        throw parse_error("Not a snapshot log");
+    pos += sizeof(MAGIC);
+    if (get_varint(pos, end) != m_fields.size() || get_varint(pos, end) != fingerprint(m_fields))
+        throw parse_error(std::string("Snapshot log doesn't match schema ") + schema.name());
+
+    // index of the records, the first one is a keyframe
+    while (pos < end) {
+        size_t offset = pos - m_data;
+        uint8_t tag = *pos++;
+        if (tag == KEYFRAME_RECORD)
+            m_keyframes.push_back(m_records.size());
+        else if (tag != DELTA_RECORD || m_keyframes.empty())
+            throw parse_error("Bad snapshot record at " + std::to_string(offset));
+        uint64_t length = get_varint(pos, end);
+        if (length > uint64_t(end - pos))
+            throw parse_error("Truncated snapshot log");
+        pos += length;
+        m_records.push_back(offset);
+    }
+}
+
+bool snapshot_reader::is_keyframe(size_t i) const
+{
+    if (i >= m_records.size())
+        throw bad_idx_error(i, m_records.size());
+    return m_data[m_records[i]] == KEYFRAME_RECORD;
+}
+
+void snapshot_reader::read(size_t i, void *record) const
+{
+    if (i >= m_records.size())
+        throw bad_idx_error(i, m_records.size());
+
+    // the nearest keyframe, then the deltas up to the record
+    auto key = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), i) - 1;
+    for (size_t k = *key; k <= i; k++)
+        apply(m_data + m_records[k], record);
+}
+
+void snapshot_reader::apply(const uint8_t *pos, void *record) const
+{
+    const uint8_t *end = m_data + m_size;
+    bool keyframe = *pos++ == KEYFRAME_RECORD;
+    uint64_t length = get_varint(pos, end);
+    end = pos + length;
+
+    const uint8_t *bitmap = pos;
+    pos += (m_fields.size() + 7) / 8;
+    if (pos > end)
+        throw parse_error("Truncated snapshot log");
+
+    auto *base = static_cast<uint8_t *>(record);
+    for (size_t i = 0; i < m_fields.size(); i++) {
+        if (!(bitmap[i / 8] >> i % 8 & 1))
+            continue;
+        auto& field = *m_fields[i].field;
+        auto *value = base + m_fields[i].offset;
+
+        if (field.item_kind == value_kind::STRING) {
+            uint64_t length = get_varint(pos, end);
+            if (length > uint64_t(end - pos))
+                throw parse_error("Truncated snapshot log");
+            reinterpret_cast<std::string *>(value)->assign(reinterpret_cast<const char *>(pos), size_t(length));
+            pos += length;
+            continue;
+        }
+
+        uint64_t prev = keyframe ? 0 : load_bits(field, value);
+        if (field.item_kind == value_kind::FLOAT) {
+            if (pos >= end || *pos >= 64)
+                throw parse_error("Bad snapshot record");
+            uint32_t zeros = *pos++;
+            store_bits(field, value, prev ^ (get_varint(pos, end) << zeros));
+        }
+        else
+            store_bits(field, value, prev + unzigzag(get_varint(pos, end)));
+    }
+}
+
+INTROSPECT_NS_CLOSE;
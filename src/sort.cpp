@@ -0,0 +1,114 @@
+#include "introspect/sort.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+INTROSPECT_NS_OPEN;
+
+namespace
+{
+    const uint64_t SIGN_BIT = uint64_t(1) << 63;
+
+    // the key as unsigned integer of the same order
+    uint64_t radix_key(const path_accessor& key, const uint8_t *record)
+    {
+        if (key.kind == value_kind::FLOAT) {
+            double value = key.get_float(record);
+            uint64_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            // negative numbers are ordered backwards
+            return bits & SIGN_BIT ? ~bits : bits | SIGN_BIT;
+        }
+        uint64_t value = uint64_t(key.get_int(record));
+        return key.field->is_signed ? value ^ SIGN_BIT : value;
+    }
+
+    std::vector<const path_accessor *> compile_keys(const schema& schema, const char *path)
+    {
+        std::vector<const path_accessor *> keys;
+        std::string name;
+        while (true) {
+            path += strspn(path, " ");
+            size_t len = strcspn(path, ",");
+            name.assign(path, len);
+            name.erase(name.find_last_not_of(' ') + 1);
+            keys.push_back(&compile_path(schema, name.c_str()));
+            if (!path[len])
+                return keys;
+            path += len + 1;
+        }
+    }
+
+    std::vector<size_t> radix_sort(const path_accessor& key, const uint8_t *records, size_t count, size_t stride)
+    {
+        std::vector<uint64_t> keys(count), keys_tmp(count);
+        std::vector<size_t> index(count), index_tmp(count);
+
+        // histograms of all the bytes in one pass
+        size_t counts[8][256] = {};
+        for (size_t i = 0; i < count; i++) {
+            uint64_t value = radix_key(key, records + i * stride);
+            keys[i] = value;
+            index[i] = i;
+            for (int b = 0; b < 8; b++)
+                counts[b][(value >> (8 * b)) & 0xFF]++;
+        }
+
+        for (int b = 0; b < 8; b++) {
+            size_t *hist = counts[b];
+            int shift = 8 * b;
+
+            // all the keys have the same byte
+            if (hist[(keys[0] >> shift) & 0xFF] == count)
+                continue;
+
+            size_t pos = 0;
+            for (int d = 0; d < 256; d++) {
+                size_t n = hist[d];
+                hist[d] = pos;
+                pos += n;
+            }
+            for (size_t i = 0; i < count; i++) {
+                size_t to = hist[(keys[i] >> shift) & 0xFF]++;
+                keys_tmp[to] = keys[i];
+                index_tmp[to] = index[i];
+            }
+            keys.swap(keys_tmp);
+            index.swap(index_tmp);
+        }
+        return index;
+    }
+
+    std::vector<size_t> comparison_sort(const std::vector<const path_accessor *>& keys,
+        const uint8_t *records, size_t count, size_t stride)
+    {
+        std::vector<size_t> index(count);
+        for (size_t i = 0; i < count; i++)
+            index[i] = i;
+
+        std::stable_sort(index.begin(), index.end(), [&](size_t a, size_t b) {
+            for (auto *key : keys) {
+                uint64_t x = radix_key(*key, records + a * stride);
+                uint64_t y = radix_key(*key, records + b * stride);
+                if (x != y)
+                    return x < y;
+            }
+            return false;
+        });
+        return index;
+    }
+}
+
+std::vector<size_t> sort_index(const schema& schema,
+    const void *records, size_t count, size_t stride, const char *path)
+{
+    auto keys = compile_keys(schema, path);
+    auto *base = static_cast<const uint8_t *>(records);
+    if (count == 0)
+        return{};
+    if (keys.size() == 1)
+        return radix_sort(*keys[0], base, count, stride);
+    return comparison_sort(keys, base, count, stride);
+}
+
+INTROSPECT_NS_CLOSE;
@@ -0,0 +1,103 @@
+#include "introspect/traverse.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+INTROSPECT_NS_OPEN;
+
+namespace
+{
+    // fields [beg, end) of the struct at the path,
+    // or elements [beg, end) of the array at the path
+    struct visit_task
+    {
+        std::string path;
+        bool        elements;
+        size_t      beg, end;
+    };
+
+    std::string join_path(const std::string& prefix, const char *name)
+    {
+        return prefix.empty() ? name : prefix + "." + name;
+    }
+
+    void plan_struct(const struct_mirror& value, const std::string& prefix, std::vector<visit_task>& tasks)
+    {
+        size_t i = 0, run = 0;
+        auto flush = [&] {
+            if (run < i)
+                tasks.push_back({ prefix, false, run, i });
+            run = i + 1;
+        };
+
+        for (auto& field : value.fields()) {
+            auto path = join_path(prefix, field.name());
+            if (auto *nested = mirror_cast<struct_mirror>(&field)) {
+                flush();
+                plan_struct(*nested, path, tasks);
+            }
+            else if (auto *array = mirror_cast<array_mirror>(&field)) {
+                size_t count = array->count();
+                if (count > ELEMENTS_PER_TASK) {
+                    flush();
+                    for (size_t beg = 0; beg < count; beg += ELEMENTS_PER_TASK)
+                        tasks.push_back({ path, true, beg, std::min(beg + ELEMENTS_PER_TASK, count) });
+                }
+            }
+            i++;
+        }
+        flush();
+    }
+
+    void run_task(const visit_task& task, const struct_mirror& root, parallel_visitor& v)
+    {
+        if (task.elements) {
+            auto& array = *mirror_cast<array_mirror>(&root.at_path(task.path.c_str()));
+
+            // the shared element mirror of struct arrays, the root is of this thread
+            if (auto *structs = mirror_cast<struct_array_mirror>(&array)) {
+                for (size_t i = task.beg; i < task.end; i++)
+                    v.visit_element(task.path.c_str(), i, structs->element(i));
+                return;
+            }
+            for (size_t i = task.beg; i < task.end; i++)
+                v.visit_element(task.path.c_str(), i, array[i]);
+            return;
+        }
+
+        auto *value = &root;
+        if (!task.path.empty())
+            value = mirror_cast<struct_mirror>(&root.at_path(task.path.c_str()));
+
+        size_t i = 0;
+        std::string path;
+        for (auto& field : value->fields()) {
+            if (i >= task.beg && i < task.end) {
+                path = join_path(task.path, field.name());
+                v.visit_field(path.c_str(), field);
+            }
+            i++;
+        }
+    }
+}
+
+void parallel_visit(const mirror_factory& factory, parallel_visitor& v, size_t threads)
+{
+    std::vector<visit_task> tasks;
+    plan_struct(*factory(), "", tasks);
+
+    std::vector<std::unique_ptr<parallel_visitor>> parts(tasks.size());
+    parallel_run(tasks.size(), threads, [&](task_source& source) {
+        auto root = factory();
+        size_t task;
+        while (source.next(task)) {
+            parts[task] = v.fork();
+            run_task(tasks[task], *root, *parts[task]);
+        }
+    });
+
+    for (auto& part : parts)
+        v.join(*part);
+}
+
+INTROSPECT_NS_CLOSE;
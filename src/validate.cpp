@@ -0,0 +1,231 @@
+#include "introspect/validate.h"
+#include "introspect/errors.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+INTROSPECT_NS_OPEN;
+
+namespace
+{
+    // limit of the rule in the domain of T
+    template<typename T>
+    T clamp_to(int64_t value)
+    {
+        using limits = std::numeric_limits<T>;
+        if (!std::is_signed<T>::value && value < 0)
+            return 0;
+        if (std::is_signed<T>::value && value < int64_t(limits::min()))
+            return limits::min();
+        if (sizeof(T) < sizeof(int64_t) && value > int64_t(limits::max()))
+            return limits::max();
+        return T(value);
+    }
+
+    //
+    // operations return true if the value violates the rule
+    //
+
+    template<typename T>
+    struct range_op
+    {
+        explicit range_op(const validation_rule& rule) :
+            lo(clamp_to<T>(rule.int_min)), hi(clamp_to<T>(rule.int_max)) {}
+
+        bool operator()(T value) const { return (value < lo) | (value > hi); }
+
+        T lo, hi;
+    };
+
+    template<typename T>
+    struct float_range_op
+    {
+        explicit float_range_op(const validation_rule& rule) :
+            lo(T(rule.float_min)), hi(T(rule.float_max)) {}
+
+        // NaN is out of any range
+        bool operator()(T value) const { return !((value >= lo) & (value <= hi)); }
+
+        T lo, hi;
+    };
+
+    template<> struct range_op<float> : float_range_op<float> { using float_range_op::float_range_op; };
+    template<> struct range_op<double> : float_range_op<double> { using float_range_op::float_range_op; };
+
+    template<typename T>
+    struct nonzero_op
+    {
+        explicit nonzero_op(const validation_rule&) {}
+
+        bool operator()(T value) const { return value == T(0); }
+    };
+
+    template<typename T>
+    struct one_of_op
+    {
+        explicit one_of_op(const validation_rule& rule) :
+            values(rule.one_of.begin()), count(rule.one_of.size()) {}
+
+        bool operator()(T value) const {
+            bool found = false;
+            for (size_t i = 0; i < count; i++)
+                found |= int64_t(value) == values[i];
+            return !found;
+        }
+
+        const int64_t *values;
+        size_t count;
+    };
+
+    template<typename T, typename Op>
+    bool violates(const Op& op, const uint8_t *data, size_t count)
+    {
+        bool bad = false;
+        for (size_t i = 0; i < count; i++) {
+            T value;
+            memcpy(&value, data + i * sizeof(T), sizeof(T));
+            bad |= op(value);
+        }
+        return bad;
+    }
+
+    template<typename T, typename Op>
+    void check_rule(const validation_rule& rule,
+        const uint8_t *records, size_t count, size_t stride, uint64_t *masks, size_t words)
+    {
+        const Op op(rule);
+        const size_t shift = rule.bit % 64;
+        uint64_t *mask = masks + rule.bit / 64;
+        const uint8_t *base = records + rule.offset;
+
+        if (rule.ops) {
+            for (size_t r = 0; r < count; r++) {
+                auto *value = const_cast<uint8_t *>(base + r * stride);
+                auto *data = static_cast<const uint8_t *>(rule.ops->data(value));
+                bool bad = violates<T>(op, data, rule.ops->count(value));
+                mask[r * words] |= uint64_t(bad) << shift;
+            }
+        }
+        else if (rule.count == 1) {
+            for (size_t r = 0; r < count; r++) {
+                T value;
+                memcpy(&value, base + r * stride, sizeof(T));
+                mask[r * words] |= uint64_t(op(value)) << shift;
+            }
+        }
+        else {
+            for (size_t r = 0; r < count; r++) {
+                bool bad = violates<T>(op, base + r * stride, rule.count);
+                mask[r * words] |= uint64_t(bad) << shift;
+            }
+        }
+    }
+
+    template<template<typename> class Op>
+    check_fn select_check(const schema_field& field)
+    {
+        if (field.item_kind == value_kind::FLOAT) {
+            switch (field.item_size) {
+            case sizeof(float): return &check_rule<float, Op<float>>;
+            case sizeof(double): return &check_rule<double, Op<double>>;
+            }
+        }
+        else {
+            bool is_signed = field.is_signed;
+            switch (field.item_size) {
+            case 1: return is_signed ? &check_rule<int8_t, Op<int8_t>> : &check_rule<uint8_t, Op<uint8_t>>;
+            case 2: return is_signed ? &check_rule<int16_t, Op<int16_t>> : &check_rule<uint16_t, Op<uint16_t>>;
+            case 4: return is_signed ? &check_rule<int32_t, Op<int32_t>> : &check_rule<uint32_t, Op<uint32_t>>;
+            case 8: return is_signed ? &check_rule<int64_t, Op<int64_t>> : &check_rule<uint64_t, Op<uint64_t>>;
+            }
+        }
+        throw not_implemented(__FUNCTION__);
+    }
+}
+
+validator::validator(const schema& schema) :
+    m_schema(&schema)
+{
+    for_each_flat(schema, false, [this](const flat_field& field) {
+        add_rules(*field.field, field.offset, field.path);
+    });
+}
+
+void validator::add_rules(const schema_field& field, ptrdiff_t offset, const std::string& path)
+{
+    const uint8_t constraints = HAS_RANGE | HAS_ONE_OF | IS_NONZERO;
+    if (!(field.flags & constraints))
+        return;
+
+    auto kind = field.item_kind;
+    if (kind != value_kind::INT && kind != value_kind::ENUM && kind != value_kind::FLOAT)
+        throw not_implemented("constraints of non-scalar values");
+
+    validation_rule rule = {};
+    rule.offset = offset;
+    rule.count = field.kind == value_kind::ARRAY ? field.count : 1;
+    rule.ops = field.kind == value_kind::VECTOR ? field.ops : nullptr;
+    rule.int_min = field.int_min;
+    rule.int_max = field.int_max;
+    rule.float_min = field.float_min;
+    rule.float_max = field.float_max;
+    rule.one_of = field.one_of;
+    rule.path = path;
+
+    auto add = [&](check_fn check) {
+        rule.check = check;
+        rule.bit = m_rules.size();
+        m_rules.push_back(rule);
+    };
+
+    if (field.flags & HAS_RANGE)
+        add(select_check<range_op>(field));
+    if (field.flags & HAS_ONE_OF)
+        add(select_check<one_of_op>(field));
+    if (field.flags & IS_NONZERO)
+        add(select_check<nonzero_op>(field));
+}
+
+bool validator::check(const void *record, uint64_t *mask) const
+{
+    return 0 == check(record, 1, m_schema->size(), mask);
+}
+
+size_t validator::check(const void *records, size_t count, size_t stride, uint64_t *masks) const
+{
+    size_t words = this->words();
+    std::fill(masks, masks + count * words, 0);
+
+    // rule by rule: one tight loop over all the records
+    auto *base = static_cast<const uint8_t *>(records);
+    for (auto& rule : m_rules)
+        rule.check(rule, base, count, stride, masks, words);
+
+    size_t invalid = 0;
+    for (size_t r = 0; r < count; r++) {
+        uint64_t any = 0;
+        for (size_t w = 0; w < words; w++)
+            any |= masks[r * words + w];
+        invalid += any != 0;
+    }
+    return invalid;
+}
+
+std::vector<std::string> validator::violations(const void *record) const
+{
+    std::vector<uint64_t> mask(words());
+    std::vector<std::string> paths;
+    if (check(record, mask.data()))
+        return paths;
+
+    for (auto& rule : m_rules) {
+        if (mask[rule.bit / 64] & (uint64_t(1) << rule.bit % 64)) {
+            // several rules of the same field
+            if (paths.empty() || paths.back() != rule.path)
+                paths.push_back(rule.path);
+        }
+    }
+    return paths;
+}
+
+INTROSPECT_NS_CLOSE;
@@ -2,6 +2,7 @@
 #include "introspect/fields.h"
 #include "introspect/io.h"
 #include "introspect/errors.h"
+#include <cstring>
 #include <sstream>
 
 INTROSPECT_NS_OPEN;
@@ -11,15 +12,49 @@ void visitor::visit(int_mirror& value) { visit(static_cast<base_mirror&>(value))
 void visitor::visit(enum_mirror& value) { visit(static_cast<int_mirror&>(value)); }
 void visitor::visit(float_mirror& value) { visit(static_cast<base_mirror&>(value)); }
 void visitor::visit(array_mirror& value) { visit(static_cast<base_mirror&>(value)); }
+void visitor::visit(vector_mirror& value) { visit(static_cast<array_mirror&>(value)); }
+void visitor::visit(string_mirror& value) { visit(static_cast<base_mirror&>(value)); }
 void visitor::visit(struct_mirror& value) { visit(static_cast<base_mirror&>(value)); }
 
+// elements of struct arrays by the shared mirror of the array, operator[] creates one per element
+void visitor::visit(struct_array_mirror& value)
+{
+    for (size_t i = 0, n = value.count(); i < n; i++)
+        value.element(i).visit(*this);
+}
+
+
 void const_visitor::visit(const base_mirror& value) { throw not_implemented(__FUNCTION__); }
 void const_visitor::visit(const int_mirror& value) { visit(static_cast<const base_mirror&>(value)); }
 void const_visitor::visit(const enum_mirror& value) { visit(static_cast<const int_mirror&>(value)); }
 void const_visitor::visit(const float_mirror& value) { visit(static_cast<const base_mirror&>(value)); }
 void const_visitor::visit(const array_mirror& value) { visit(static_cast<const base_mirror&>(value)); }
+void const_visitor::visit(const vector_mirror& value) { visit(static_cast<const array_mirror&>(value)); }
+void const_visitor::visit(const string_mirror& value) { visit(static_cast<const base_mirror&>(value)); }
 void const_visitor::visit(const struct_mirror& value) { visit(static_cast<const base_mirror&>(value)); }
 
+void const_visitor::visit(const struct_array_mirror& value)
+{
+    for (size_t i = 0, n = value.count(); i < n; i++)
+        value.element(i).visit(*this);
+}
+
+std::string signature_type(const char *signature)
+{
+    // gcc, clang: "... type_name() [with T = foo_t]" or "[T = foo_t]"
+    // msvc: "... type_name<struct foo_t>(void)"
+    if (auto *arg = strstr(signature, "T = ")) {
+        arg += 4;
+        return std::string(arg, strcspn(arg, ";]"));
+    }
+    if (auto *arg = strstr(signature, "type_name<")) {
+        arg += 10;
+        auto *end = strrchr(arg, '>');
+        return std::string(arg, end ? end - arg : strlen(arg));
+    }
+    return signature;
+}
+
 variant::variant(variant&& var)
 {
     if (var.is_inline()) {
@@ -57,4 +92,59 @@ base_field& struct_mirror::at(const char *name)
     throw bad_key_error(name, type());
 }
 
+bool base_mirror::subtree_marked() const
+{
+    if (marked())
+        return true;
+
+    // the root struct isn't a field, its fields test their own subtrees
+    if (auto *nested = mirror_cast<struct_mirror>(this)) {
+        for (auto& field : nested->fields()) {
+            if (field.subtree_marked())
+                return true;
+        }
+    }
+    return false;
+}
+
+bool has_marked(const base_mirror& value)
+{
+    return value.subtree_marked();
+}
+
+base_field& struct_mirror::at_path(const char *path)
+{
+    std::string name;
+    auto *node = this;
+    while (true) {
+        size_t len = strcspn(path, ".[");
+        name.assign(path, len);
+        auto& field = node->at(name.c_str());
+        path += len;
+        if (*path == 0)
+            return field;
+
+        // elements of struct arrays by the shared mirror of the array
+        if (*path == '[') {
+            auto *array = mirror_cast<struct_array_mirror>(&field);
+            if (!array)
+                throw bad_key_error(path, field.name());
+            char *end;
+            auto index = strtol(path + 1, &end, 10);
+            if (end == path + 1 || *end != ']' || end[1] != '.')
+                throw bad_key_error(path, field.name());
+            if (index < 0)
+                throw bad_idx_error(index, array->count());
+            node = &array->element(size_t(index));
+            path = end + 2;
+            continue;
+        }
+
+        node = mirror_cast<struct_mirror>(&field);
+        if (!node)
+            throw bad_key_error(path + 1, field.name());
+        path++;
+    }
+}
+
 INTROSPECT_NS_CLOSE;
\ No newline at end of file
@@ -1,11 +1,33 @@
 #include <iostream>
 #include <sstream>
 #include <utility>
+#include <algorithm>
+#include <thread>
+#include <new>
 #include <stdint.h>
 #include <gtest/gtest.h>
 #include "introspect/fields.h"
 #include "introspect/attrib.h"
 #include "introspect/io.h"
+#include "introspect/lazy.h"
+#include "introspect/bulk.h"
+#include "introspect/cursor.h"
+#include "introspect/schema.h"
+#include "introspect/validate.h"
+#include "introspect/path.h"
+#include "introspect/static_path.h"
+#include "introspect/convert.h"
+#include "introspect/observe.h"
+#include "introspect/layout.h"
+#include "introspect/profile.h"
+#include "introspect/prometheus.h"
+#include "introspect/dynamic.h"
+#include "introspect/sort.h"
+#include "introspect/packed.h"
+#include "introspect/traverse.h"
+#include "introspect/snapshot.h"
+#include "introspect/layers.h"
+#include "introspect/realtime.h"
 
 using namespace introspect;
 
@@ -212,3 +234,1785 @@ TEST(Fields, Enumerate)
     test_fields<enum_mirror>  (set, { &set.e });
     test_fields<struct_mirror>(set, { &set.p, &set.s });
 }
+
+TEST(Lazy, ParseOnAccess)
+{
+    settings_t settings1, settings2;
+
+    set_example(settings1);
+    set_default(settings2);
+
+    settings_c set(settings1);
+
+    std::stringstream buffer;
+    buffer << set;
+
+    set.addr(&settings2);
+    lazy_document doc(buffer, set);
+    EXPECT_EQ(doc.size(), 14u);
+    EXPECT_EQ(doc.parsed(), 0u);
+
+    EXPECT_EQ(dynamic_cast<int_mirror&>(doc["p.Y"]).int_value(), 11);
+    EXPECT_EQ(settings2.p.y, 11);
+    EXPECT_EQ(settings2.p.x, 0);
+    EXPECT_EQ(settings2.i, 0);
+
+    doc.materialize("s");
+    EXPECT_EQ(doc.parsed(), 4u);
+    EXPECT_EQ(settings2.s.z, 15);
+
+    doc.materialize();
+    EXPECT_EQ(doc.parsed(), 14u);
+    EXPECT_EQ(settings1, settings2);
+}
+
+TEST(IO, PushParser)
+{
+    settings_t settings1, settings2;
+
+    set_example(settings1);
+    set_default(settings2);
+
+    settings_c set(settings1);
+
+    std::stringstream buffer;
+    buffer << set;
+    std::string text = buffer.str();
+
+    set.addr(&settings2);
+    push_parser parser(set);
+
+    // feed by small chunks, splitting lines
+    size_t lines = 0;
+    for (size_t pos = 0; pos < text.size(); pos += 7)
+        lines += parser.feed(text.data() + pos, std::min<size_t>(7, text.size() - pos)).applied;
+    lines += parser.finish();
+
+    EXPECT_EQ(lines, 14u);
+    EXPECT_FALSE(parser.pending());
+    EXPECT_EQ(settings1, settings2);
+
+    // bad lines are reported, but don't break the stream; blank lines aren't counted
+    const char chunk[] = "i = x\nj = 42\n\r\nq = 1\nd = 0.5\nb = ";
+    auto result = parser.feed(chunk, sizeof(chunk) - 1);
+    EXPECT_EQ(result.applied, 2u);
+    EXPECT_EQ(result.failed, 2u);
+    EXPECT_THROW(std::rethrow_exception(result.error), parse_error);
+    EXPECT_EQ(settings2.j, 42);
+    EXPECT_EQ(settings2.d, 0.5);
+    EXPECT_TRUE(parser.pending());
+    result = parser.feed("0\n", 2);
+    EXPECT_EQ(result.applied, 1u);
+    EXPECT_EQ(result.failed, 0u);
+    EXPECT_FALSE(result.error);
+    EXPECT_EQ(settings2.b, false);
+    EXPECT_EQ(parser.feed("\n\n", 2).applied, 0u);
+}
+
+TEST(Bulk, ParseRecords)
+{
+    std::ostringstream out;
+    for (int k = 0; k < 1000; k++)
+        out << "i = " << k << "\nj = " << 2 * k << "\np.X = " << -k << "\n\n";
+    std::string text = out.str();
+
+    auto records = parse_records<settings_t>(text.data(), text.size(), 4);
+
+    ASSERT_EQ(records.size(), 1000u);
+    for (int k = 0; k < 1000; k++) {
+        EXPECT_EQ(records[k].i, k);
+        EXPECT_EQ(records[k].j, 2 * k);
+        EXPECT_EQ(records[k].p.x, -k);
+    }
+
+    // the vector is reused, stale values are not kept
+    for (auto& record : records)
+        record.d = 1.5;
+    parse_records<settings_t>(text.data(), text.size(), records, 4);
+    EXPECT_EQ(records[10].i, 10);
+    EXPECT_EQ(records[10].d, 0.0);
+}
+
+TEST(Bulk, ErrorLine)
+{
+    std::ostringstream out;
+    for (int k = 0; k < 1000; k++)
+        out << "i = " << (k == 700 || k == 300 ? "x" : "1") << "\n\n";
+    std::string text = out.str();
+
+    std::vector<settings_t> records;
+    try {
+        parse_records<settings_t>(text.data(), text.size(), records, 4);
+        FAIL();
+    }
+    catch (const record_error& error) {
+        EXPECT_EQ(error.line, 601u);
+    }
+}
+
+TEST(Cursor, Stride)
+{
+    std::vector<settings_t> records(100);
+    record_cursor<settings_t> cursor(records);
+    ASSERT_EQ(cursor.count(), 100u);
+
+    // nested fields follow the record without rebinding
+    auto& y = dynamic_cast<int_mirror&>(cursor->at_path("p.Y"));
+    for (cursor.seek(0); cursor.valid(); cursor.next())
+        y.int_value(int64_t(cursor.index()));
+    for (int k = 0; k < 100; k++)
+        EXPECT_EQ(records[k].p.y, k);
+
+    // every other record
+    record_cursor<point_t> points(&records[0].s, 50, 2 * sizeof(settings_t));
+    std::ostringstream out;
+    print_visitor printer(out);
+    records[2].s = { 1, 2, 3 };
+    points.seek(1);
+    (*points).visit(printer);
+    EXPECT_EQ(out.str(), "X = 1\nY = 2\nZ = 3\n");
+
+    out.str("");
+    points.visit(printer);
+    auto text = out.str();
+    EXPECT_EQ(std::count(text.begin(), text.end(), '\n'), 150);
+    EXPECT_FALSE(points.valid());
+}
+
+TEST(Kind, MirrorCast)
+{
+    settings_t settings;
+    set_example(settings);
+    settings_c set(settings);
+
+    EXPECT_EQ(set.kind(), mirror_kind::STRUCT);
+    EXPECT_EQ(set["a"].kind(), mirror_kind::ARRAY);
+    EXPECT_EQ(set["d"].kind(), mirror_kind::FLOAT);
+    EXPECT_EQ(set["e"].kind(), mirror_kind::ENUM);
+    EXPECT_EQ(set["p"].kind(), mirror_kind::STRUCT);
+
+    // enum is int as well
+    auto *e = mirror_cast<int_mirror>(&set["e"]);
+    ASSERT_NE(e, nullptr);
+    EXPECT_EQ(e->int_value(), VALUE1);
+    EXPECT_EQ(mirror_cast<float_mirror>(&set["e"]), nullptr);
+    EXPECT_EQ(mirror_cast<int_mirror>(&set.at_path("p.Y"))->int_value(), 11);
+
+    // attributes of the field
+    auto& a = set["a"];
+    EXPECT_EQ(a.attr_bits(), uint32_t(ATTR_FILLER | ATTR_MAPPING | ATTR_MIN_COUNT));
+    EXPECT_EQ(attr_cast<with_min_count>(&a)->get_min_count(), 1u);
+    EXPECT_EQ(attr_cast<with_name>(&a), nullptr);
+    EXPECT_EQ(a.find_attr(ATTR_MAPPING), nullptr); // mappings are iterated by target
+    EXPECT_STREQ(attr_cast<with_name>(&set.at_path("p.X"))->get_name(), "X");
+
+    // through variant
+    auto element = mirror_cast<array_mirror>(&a)->at(1);
+    EXPECT_EQ(element.kind(), mirror_kind::INT);
+    EXPECT_EQ(mirror_cast<int_mirror>(&element)->int_value(), 2);
+}
+
+// dynamic containers
+
+struct connection_t
+{
+    std::string host;
+    std::vector<int32_t> ports;
+    std::vector<std::string> tags;
+    int32_t timeout;
+};
+
+STRUCT_FIELDS(connection_t)
+{
+    STRUCT_FIELD(host,    with_name("host"));
+    STRUCT_FIELD(ports,   with_min_count(1));
+    STRUCT_FIELD(tags,    with_name("tags"));
+    STRUCT_FIELD(timeout, with_default(30));
+};
+
+TEST(Containers, SaveLoadCompare)
+{
+    connection_t conn1, conn2;
+    conn1.host = "example.org \"quoted\"\n";
+    conn1.ports = { 80, 443, 8080 };
+    conn1.tags = { "a", "b,c" };
+    conn1.timeout = 5;
+    conn2.ports = { 1, 2, 3, 4, 5, 6, 7 };
+    conn2.timeout = 0;
+
+    mirror<connection_t, simple_fields> conn(conn1);
+
+    std::stringstream buffer;
+    buffer << conn;
+    EXPECT_EQ(buffer.str(),
+        "host = \"example.org \\\"quoted\\\"\\n\"\n"
+        "ports = { 80, 443, 8080 }\n"
+        "tags = { \"a\", \"b,c\" }\n"
+        "timeout = 5\n");
+
+    // existing capacity is reused
+    auto *data = conn2.ports.data();
+    conn.addr(&conn2);
+    while (!buffer.eof())
+        buffer >> conn;
+
+    EXPECT_EQ(conn1.host, conn2.host);
+    EXPECT_EQ(conn1.ports, conn2.ports);
+    EXPECT_EQ(conn1.tags, conn2.tags);
+    EXPECT_EQ(conn1.timeout, conn2.timeout);
+    EXPECT_EQ(conn2.ports.data(), data);
+
+    // empty vector
+    std::stringstream empty("tags = { }\n");
+    empty >> conn;
+    EXPECT_TRUE(conn2.tags.empty());
+
+    std::stringstream low("ports = { }\n");
+    EXPECT_THROW(low >> conn, low_count_error);
+}
+
+// arrays of structs
+
+struct shape_t;
+
+STRUCT_FIELDS(shape_t)
+{
+    STRUCT_FIELD2(id,  int,         with_default(0));
+    STRUCT_FIELD2(pts, point_t[3],  with_name("pts"));
+};
+
+struct shape_t : struct_fields<shape_t, raw_fields> {};
+
+TEST(StructArray, SaveLoadCompare)
+{
+    shape_t shape1, shape2;
+    shape1.id = 7;
+    for (int i = 0; i < 3; i++)
+        shape1.pts[i] = { i, 10 * i, 100 * i };
+    memset(&shape2, 0, sizeof(shape2));
+
+    mirror<shape_t, simple_fields> shape(shape1);
+    EXPECT_EQ(shape.pts.count(), 3u);
+
+    std::stringstream buffer;
+    buffer << shape;
+    EXPECT_EQ(buffer.str(),
+        "id = 7\n"
+        "pts[0].X = 0\npts[0].Y = 0\npts[0].Z = 0\n"
+        "pts[1].X = 1\npts[1].Y = 10\npts[1].Z = 100\n"
+        "pts[2].X = 2\npts[2].Y = 20\npts[2].Z = 200\n");
+
+    shape.addr(&shape2);
+    while (!buffer.eof())
+        buffer >> shape;
+    EXPECT_EQ(0, memcmp(&shape1, &shape2, sizeof(shape_t)));
+
+    // shared element mirror through variant
+    auto& element = dynamic_cast<struct_mirror&>(shape.pts.element(2));
+    EXPECT_EQ(dynamic_cast<int_mirror&>(element["Y"]).int_value(), 20);
+
+    // own mirrors of elements through variant
+    auto first = shape.pts[0];
+    auto second = shape.pts[1];
+    EXPECT_EQ(first.addr(), &shape2.pts[0]);
+    EXPECT_EQ(second.addr(), &shape2.pts[1]);
+
+    std::stringstream bad("pts[3].X = 1\n");
+    EXPECT_THROW(bad >> shape, bad_idx_error);
+
+    // lazy document with indexed paths
+    memset(&shape2, 0, sizeof(shape2));
+    lazy_document doc("id = 7\npts[1].Y = 10\npts[2].Z = 200\n", shape);
+    doc.materialize("pts");
+    EXPECT_EQ(doc.parsed(), 2u);
+    EXPECT_EQ(shape2.pts[2].z, 200);
+    EXPECT_EQ(shape2.id, 0);
+
+    EXPECT_EQ(dynamic_cast<int_mirror&>(doc.at("pts[1].Y")).int_value(), 10);
+    EXPECT_EQ(dynamic_cast<int_mirror&>(doc.at("id")).int_value(), 7);
+    EXPECT_THROW(doc.at("pts[0].Y"), bad_key_error);
+    EXPECT_THROW(doc.at("pts[1].Q"), bad_key_error);
+    EXPECT_EQ(&shape.at_path("pts[2].Z"), &shape.pts.element(2)["Z"]);
+    EXPECT_THROW(shape.at_path("pts[3].Z"), bad_idx_error);
+    EXPECT_THROW(shape.at_path("pts[1]"), bad_key_error);
+}
+
+TEST(StructArray, TopLevel)
+{
+    point_t points[2] = { { 1, 2, 3 }, { 4, 5, 6 } };
+    mirror<point_t[2], simple_fields> array(points);
+
+    std::stringstream buffer;
+    buffer << array;
+    EXPECT_EQ(buffer.str(), "[0].X = 1\n[0].Y = 2\n[0].Z = 3\n[1].X = 4\n[1].Y = 5\n[1].Z = 6\n");
+
+    std::stringstream input("[1].Y = 50\n");
+    input >> array;
+    EXPECT_EQ(points[1].y, 50);
+}
+
+// grouped text format
+
+TEST(IO, GroupedFormat)
+{
+    settings_t settings1, settings2;
+    set_example(settings1);
+    set_default(settings2);
+
+    settings_c set(settings1);
+    std::stringstream buffer;
+    print(buffer, set, text_format::GROUPED);
+    EXPECT_EQ(buffer.str(),
+        "a = { 1, 2, 3 }\nb = 1\nc = 120\nd = 4.5\ne = VALUE1\nf = 6.7\ni = 8\nj = 9\n"
+        "p { X = 10, Y = 11, Z = 12 }\n"
+        "s { X = 13, Y = 14, Z = 15 }\n");
+
+    set.addr(&settings2);
+    while (!buffer.eof())
+        buffer >> set;
+    EXPECT_EQ(settings1, settings2);
+
+    // blocks and paths are mixed
+    std::stringstream mixed("p { X = 1, Y = 2 }\ns.Z = 3\np { }\n");
+    while (!mixed.eof())
+        mixed >> set;
+    EXPECT_EQ(settings2.p.x, 1);
+    EXPECT_EQ(settings2.p.y, 2);
+    EXPECT_EQ(settings2.s.z, 3);
+
+    std::stringstream bad("p { X = 1 Y = 2 }\n");
+    EXPECT_THROW(bad >> set, token_error);
+
+    // hand-written blocks over lines, with a comma before the closing brace
+    std::stringstream lines("p {\n  X = 5,\n  Y = 6\n}\ns { Z = 7, }\ni = 9\n");
+    while (!lines.eof())
+        lines >> set;
+    EXPECT_EQ(settings2.p.x, 5);
+    EXPECT_EQ(settings2.p.y, 6);
+    EXPECT_EQ(settings2.s.z, 7);
+    EXPECT_EQ(settings2.i, 9);
+
+    std::stringstream unclosed("p {\n  X = 1\n");
+    EXPECT_THROW(unclosed >> set, token_error);
+
+    // the lazy document indexes paths only
+    EXPECT_THROW(lazy_document("d = 1\np { X = 1 }\n", set), parse_error);
+
+    // elements of struct arrays
+    shape_t shape1, shape2;
+    shape1.id = 7;
+    for (int i = 0; i < 3; i++)
+        shape1.pts[i] = { i, 10 * i, 100 * i };
+    memset(&shape2, 0, sizeof(shape2));
+
+    mirror<shape_t, simple_fields> shape(shape1);
+    std::stringstream shapes;
+    print(shapes, shape, text_format::GROUPED);
+    EXPECT_EQ(shapes.str(),
+        "id = 7\n"
+        "pts[0] { X = 0, Y = 0, Z = 0 }\n"
+        "pts[1] { X = 1, Y = 10, Z = 100 }\n"
+        "pts[2] { X = 2, Y = 20, Z = 200 }\n");
+
+    shape.addr(&shape2);
+    while (!shapes.eof())
+        shapes >> shape;
+    EXPECT_EQ(0, memcmp(&shape1, &shape2, sizeof(shape_t)));
+}
+
+// layered config
+
+TEST(Layers, Merge)
+{
+    layered_loader<settings_t> loader;
+    loader.add_layer("base", "a = { 1, 2, 3 }\nd = 4.5\ni = 8\np { X = 10, Y = 11, Z = 12 }\n");
+    loader.add_layer("env", "d = 5.5\np.X = 20\n");
+    loader.add_layer("host", "p { Y = 0 }\ne = VALUE1\n");
+    EXPECT_EQ(loader.layers(), 3u);
+
+    settings_t settings;
+    set_default(settings);
+    settings.j = 9;
+    loader.merge(settings);
+
+    EXPECT_EQ(settings.a[2], 3);
+    EXPECT_EQ(settings.d, 5.5);
+    EXPECT_EQ(settings.i, 8);
+    EXPECT_EQ(settings.e, VALUE1);
+    EXPECT_EQ(settings.j, 9);
+    EXPECT_EQ(settings.p.x, 20);
+    EXPECT_EQ(settings.p.y, 0); // the default value overrides too
+    EXPECT_EQ(settings.p.z, 12);
+
+    EXPECT_EQ(loader.name(loader.provenance("p.X")), "env");
+    EXPECT_EQ(loader.name(loader.provenance("p.Y")), "host");
+    EXPECT_EQ(loader.name(loader.provenance("p.Z")), "base");
+    EXPECT_EQ(loader.provenance("j"), NO_LAYER);
+    EXPECT_THROW(loader.provenance("p.W"), bad_key_error);
+
+    // elements of struct arrays are separate fields
+    layered_loader<shape_t> shapes;
+    shapes.add_layer("base", "id = 7\npts[0] { X = 1, Y = 2 }\npts[2].Z = 3\n");
+    shapes.add_layer("host", "pts[2].X = 4\n");
+    EXPECT_EQ(shapes.index().count(), 10u);
+
+    shape_t shape;
+    memset(&shape, 0, sizeof(shape));
+    shapes.merge(shape);
+    EXPECT_EQ(shape.id, 7);
+    EXPECT_EQ(shape.pts[0].y, 2);
+    EXPECT_EQ(shape.pts[2].x, 4);
+    EXPECT_EQ(shape.pts[2].z, 3);
+    EXPECT_EQ(shapes.name(shapes.provenance("pts[2].Z")), "base");
+}
+
+// schema and views
+
+TEST(Schema, Describe)
+{
+    auto& s = schema::of<settings_t>();
+    EXPECT_EQ(s.count(), 10u);
+    EXPECT_EQ(s.size(), sizeof(settings_t));
+
+    auto& a = s.at("a");
+    EXPECT_EQ(a.kind, value_kind::ARRAY);
+    EXPECT_EQ(a.item_kind, value_kind::INT);
+    EXPECT_EQ(a.count, 3u);
+    EXPECT_EQ(a.min_count, 1u);
+    EXPECT_EQ(a.flags & (HAS_FILLER | HAS_MIN_COUNT), HAS_FILLER | HAS_MIN_COUNT);
+
+    auto& p = s.at("p");
+    EXPECT_EQ(p.kind, value_kind::STRUCT);
+    EXPECT_EQ(p.nested, &schema::of<point_t>());
+    EXPECT_STREQ((*p.nested)[0].name, "X");
+    EXPECT_EQ(s.at("e").kind, value_kind::ENUM);
+    EXPECT_EQ(s.at("f").item_size, sizeof(float));
+    EXPECT_TRUE(s.at("b").flags & IS_BOOL);
+}
+
+TEST(Schema, View)
+{
+    static_assert(std::is_trivially_copyable<struct_view<settings_t>>::value, "view should be trivially copyable");
+    static_assert(sizeof(struct_view<settings_t>) == 2 * sizeof(void *), "view should be a schema and a pointer");
+
+    settings_t settings;
+    set_example(settings);
+
+    settings_c set(settings);
+    std::ostringstream out1, out2;
+    out1 << set;
+    out2 << view_of(settings);
+    EXPECT_EQ(out1.str(), out2.str());
+
+    auto view = view_of(settings);
+    EXPECT_EQ(view.at_path("p.Y").int_value(), 11);
+    view.at_path("s.Z").int_value(-5);
+    EXPECT_EQ(settings.s.z, -5);
+    view["d"].float_value(0.25);
+    EXPECT_EQ(settings.d, 0.25);
+    EXPECT_EQ(view["a"].item(2).int_value(), 3);
+
+    shape_t shape;
+    shape.id = 1;
+    for (int i = 0; i < 3; i++)
+        shape.pts[i] = { i, i, i };
+    mirror<shape_t, simple_fields> shape_m(shape);
+    std::ostringstream out3, out4;
+    out3 << shape_m;
+    out4 << view_of(shape);
+    EXPECT_EQ(out3.str(), out4.str());
+
+    connection_t conn;
+    conn.host = "host";
+    conn.ports = { 1, 2 };
+    conn.tags = { "x" };
+    conn.timeout = 3;
+    mirror<connection_t, simple_fields> conn_m(conn);
+    std::ostringstream out5, out6;
+    out5 << conn_m;
+    out6 << view_of(conn);
+    EXPECT_EQ(out5.str(), out6.str());
+}
+
+// compiled paths
+
+TEST(Path, Compile)
+{
+    settings_t settings1, settings2;
+    set_example(settings1);
+    set_example(settings2);
+    settings2.p.x = 20;
+
+    settings_c set(settings1);
+    auto x = compile_path(set, "p.X");
+    auto a = compile_path(set, "a[2]");
+    auto d = compile_path(set, "d");
+    EXPECT_EQ(x.kind(), value_kind::INT);
+    EXPECT_EQ(&x.accessor(), &compile_path(schema::of<settings_t>(), "p.X"));
+
+    EXPECT_EQ(x.get_int(), 10);
+    EXPECT_EQ(a.get_int(), 3);
+    EXPECT_EQ(d.get_float(), 4.5);
+    a.set_float(7.9);
+    d.set_int(-2);
+    EXPECT_EQ(settings1.a[2], 7);
+    EXPECT_EQ(settings1.d, -2.0);
+
+    // follows the mirror
+    set.addr(&settings2);
+    EXPECT_EQ(x.get_int(), 20);
+    x.set_int(21);
+    EXPECT_EQ(settings2.p.x, 21);
+
+    shape_t shape = {};
+    mirror<shape_t, simple_fields> shape_m(shape);
+    compile_path(shape_m, "pts[1].Y").set_int(5);
+    EXPECT_EQ(shape.pts[1].y, 5);
+
+    EXPECT_THROW(compile_path(set, "p.Q"), bad_key_error);
+    EXPECT_THROW(compile_path(set, "a[3]"), bad_idx_error);
+    EXPECT_THROW(compile_path(set, "d.X"), bad_key_error);
+    EXPECT_THROW(compile_path(set, "p"), not_implemented);
+}
+
+#ifdef INTROSPECT_HAS_STATIC_PATH
+
+TEST(Path, Static)
+{
+    settings_t settings;
+    set_example(settings);
+
+    static_assert(std::is_same<decltype(get<"p.X">(settings)), int32_t&>::value, "plain reference to the field");
+    EXPECT_EQ(&get<"p.X">(settings), &settings.p.x);
+    EXPECT_EQ(&get<"s.Z">(settings), &settings.s.z);
+    EXPECT_EQ(get<"a">(settings)[1], 2);
+
+    get<"d">(settings) = 0.5;
+    EXPECT_EQ(settings.d, 0.5);
+
+    const settings_t& ref = settings;
+    static_assert(std::is_same<decltype(get<"j">(ref)), const int64_t&>::value, "const is kept");
+    EXPECT_EQ(get<"j">(ref), 9);
+
+    connection_t conn;
+    get<"host">(conn) = "localhost";
+    EXPECT_EQ(conn.host, "localhost");
+}
+
+struct wide_settings_t
+{
+    int32_t v0, v1, v2, v3, v4, v5, v6, v7, v8, v9;
+    int32_t v10, v11, v12, v13, v14, v15, v16, v17, v18, v19;
+};
+
+STRUCT_FIELDS(wide_settings_t)
+{
+    STRUCT_FIELD(v0, with_name("v0"));
+    STRUCT_FIELD(v1, with_name("v1"));
+    STRUCT_FIELD(v2, with_name("v2"));
+    STRUCT_FIELD(v3, with_name("v3"));
+    STRUCT_FIELD(v4, with_name("v4"));
+    STRUCT_FIELD(v5, with_name("v5"));
+    STRUCT_FIELD(v6, with_name("v6"));
+    STRUCT_FIELD(v7, with_name("v7"));
+    STRUCT_FIELD(v8, with_name("v8"));
+    STRUCT_FIELD(v9, with_name("v9"));
+    STRUCT_FIELD(v10, with_name("v10"));
+    STRUCT_FIELD(v11, with_name("v11"));
+    STRUCT_FIELD(v12, with_name("v12"));
+    STRUCT_FIELD(v13, with_name("v13"));
+    STRUCT_FIELD(v14, with_name("v14"));
+    STRUCT_FIELD(v15, with_name("v15"));
+    STRUCT_FIELD(v16, with_name("v16"));
+    STRUCT_FIELD(v17, with_name("v17"));
+    STRUCT_FIELD(v18, with_name("v18"));
+    STRUCT_FIELD(v19, with_name("v19"));
+};
+
+TEST(Path, StaticWide)
+{
+    // more fields than structured bindings were written for by hand
+    wide_settings_t wide{};
+    get<"v19">(wide) = 19;
+    get<"v0">(wide) = 1;
+    EXPECT_EQ(wide.v19, 19);
+    EXPECT_EQ(wide.v0, 1);
+
+    auto copy = convert<wide_settings_t>(wide);
+    EXPECT_EQ(copy.v19, 19);
+    EXPECT_EQ(copy.v10, 0);
+}
+
+struct plane_point_t
+{
+    double x, y;
+};
+
+STRUCT_FIELDS(plane_point_t)
+{
+    STRUCT_FIELD(x, with_name("X"));
+    STRUCT_FIELD(y, with_name("Y"));
+};
+
+struct compact_settings_t
+{
+    int64_t i;
+    plane_point_t p;
+    std::array<int16_t, 2> a;
+    double f;
+    int32_t e;
+    std::string comment;
+};
+
+STRUCT_FIELDS(compact_settings_t)
+{
+    STRUCT_FIELD(i, with_default(0));
+    STRUCT_FIELD(p, with_name("p"));
+    STRUCT_FIELD(a, with_min_count(1));
+    STRUCT_FIELD(f, with_default(0.0));
+    STRUCT_FIELD(e, with_default(0));
+    STRUCT_FIELD(comment, with_name("comment"));
+};
+
+TEST(Path, Convert)
+{
+    settings_t settings;
+    set_example(settings);
+
+    auto compact = convert<compact_settings_t>(settings);
+    EXPECT_EQ(compact.i, 8);
+    EXPECT_EQ(compact.p.x, 10.0);
+    EXPECT_EQ(compact.p.y, 11.0);
+    EXPECT_EQ(compact.a[0], 1);
+    EXPECT_EQ(compact.a[1], 2);
+    EXPECT_EQ(compact.f, 6.7f);
+    EXPECT_EQ(compact.e, 1);
+    EXPECT_EQ(compact.comment, "");
+
+    // the fields not in the source are kept
+    compact.i = 20;
+    compact.p.x = 21.5;
+    compact.a[1] = 22;
+    compact.e = VALUE0;
+    convert_into(settings, compact);
+    EXPECT_EQ(settings.i, 20);
+    EXPECT_EQ(settings.p.x, 21);
+    EXPECT_EQ(settings.p.y, 11);
+    EXPECT_EQ(settings.p.z, 12);
+    EXPECT_EQ(settings.a[1], 22);
+    EXPECT_EQ(settings.a[2], 3);
+    EXPECT_EQ(settings.e, VALUE0);
+    EXPECT_EQ(settings.j, 9);
+    EXPECT_EQ(settings.s.x, 13);
+
+    // C arrays of the same type are converted by elements
+    auto same = convert<settings_t>(settings);
+    EXPECT_TRUE(same == settings);
+}
+
+#endif
+
+// constraints
+
+struct limits_t
+{
+    int32_t port;
+    uint8_t level;
+    float ratio;
+    std::array<int32_t, 2> weights;
+    std::vector<int32_t> codes;
+    enum_t mode;
+};
+
+STRUCT_FIELDS(limits_t)
+{
+    STRUCT_FIELD(port,    with_range(1, 65535));
+    STRUCT_FIELD(level,   with_one_of(1, 2, 4));
+    STRUCT_FIELD(ratio,   with_range(0.0f, 1.0f));
+    STRUCT_FIELD(weights, with_nonzero());
+    STRUCT_FIELD(codes,   with_range(0, 9));
+    STRUCT_FIELD(mode,    with_one_of(VALUE1), with_nonzero());
+};
+
+struct service_t
+{
+    int32_t id;
+    limits_t limits;
+};
+
+STRUCT_FIELDS(service_t)
+{
+    STRUCT_FIELD(id,      with_range(0, 100));
+    STRUCT_FIELD(limits,  with_name("limits"));
+};
+
+TEST(Validate, Constraints)
+{
+    auto& f = schema::of<limits_t>().at("level");
+    EXPECT_TRUE(f.flags & HAS_ONE_OF);
+    EXPECT_EQ(f.one_of.size(), 3u);
+    EXPECT_EQ(validator::of<service_t>().count(), 8u);
+
+    service_t service = { 7, { 8080, 2, 0.5f, { 1, 2 }, { 0, 9 }, VALUE1 } };
+    EXPECT_TRUE(is_valid(service));
+
+    // mirror with constraints still parses
+    mirror<limits_t, simple_fields> limits(service.limits);
+    std::stringstream input("port = 0\nratio = 1.5\ncodes = { 3, 10 }\n");
+    while (!input.eof())
+        input >> limits;
+    service.limits.weights[1] = 0;
+    service.id = -1;
+
+    std::vector<std::string> expected = { "id", "limits.port", "limits.ratio", "limits.weights", "limits.codes" };
+    EXPECT_EQ(violations(service), expected);
+
+    service.limits.mode = VALUE0;
+    service.limits.ratio = std::numeric_limits<float>::quiet_NaN();
+    expected = { "id", "limits.port", "limits.ratio", "limits.weights", "limits.codes", "limits.mode" };
+    EXPECT_EQ(violations(service), expected);
+}
+
+TEST(Validate, Records)
+{
+    std::vector<service_t> records(1000);
+    for (int k = 0; k < 1000; k++)
+        records[k] = { k % 100, { 1 + k, 4, 0.25f, { 1, 1 }, { }, VALUE1 } };
+    records[10].limits.level = 3;
+    records[500].id = 200;
+    records[999].limits.weights[0] = 0;
+
+    std::vector<uint64_t> masks;
+    EXPECT_EQ(validate(records.data(), records.size(), masks), 3u);
+
+    auto& rules = validator::of<service_t>();
+    ASSERT_EQ(rules.words(), 1u);
+    auto bit = [&](const char *path) {
+        for (size_t i = 0; i < rules.count(); i++) {
+            if (rules[i].path == path)
+                return uint64_t(1) << rules[i].bit;
+        }
+        return uint64_t(0);
+    };
+
+    for (size_t k = 0; k < records.size(); k++) {
+        if (k == 10)
+            EXPECT_EQ(masks[k], bit("limits.level"));
+        else if (k == 500)
+            EXPECT_EQ(masks[k], bit("id"));
+        else if (k == 999)
+            EXPECT_EQ(masks[k], bit("limits.weights"));
+        else
+            EXPECT_EQ(masks[k], 0u);
+    }
+}
+
+// change subscriptions
+
+TEST(Observe, Dispatch)
+{
+    settings_t settings;
+    set_example(settings);
+    settings_c set(settings);
+
+    observer changes(set);
+    int all = 0, p = 0, px = 0, d = 0, a = 0;
+    std::vector<std::string> paths;
+    changes.subscribe("", [&](const change_set& c) { all++; paths = c.paths(); });
+    changes.subscribe("p", [&](const change_set&) { p++; });
+    changes.subscribe("p.X", [&](const change_set&) { px++; });
+    changes.subscribe("d", [&](const change_set&) { d++; });
+    auto id = changes.subscribe("a", [&](const change_set& c) { a++; EXPECT_TRUE(c.contains("a")); });
+    EXPECT_THROW(changes.subscribe("q", nullptr), bad_key_error);
+
+    // the same values don't mark
+    std::stringstream same("d = 4.5\np.X = 10\na = { 1, 2, 3 }\n");
+    while (!same.eof())
+        same >> set;
+    EXPECT_FALSE(changes.pending());
+
+    // one call per batch
+    std::stringstream reload("p.Y = 1\np.Z = 2\na = { 1, 5, 3 }\nd = 4.5\n");
+    while (!reload.eof())
+        reload >> set;
+    set.i.set(100);
+    changes.dispatch();
+    EXPECT_EQ(all, 1);
+    EXPECT_EQ(p, 1);
+    EXPECT_EQ(px, 0);
+    EXPECT_EQ(d, 0);
+    EXPECT_EQ(a, 1);
+    std::vector<std::string> expected = { "a", "i", "p.Y", "p.Z" };
+    EXPECT_EQ(paths, expected);
+
+    // nothing new
+    changes.dispatch();
+    EXPECT_EQ(all, 1);
+
+    // assignment of the parent struct notifies the nested fields
+    changes.unsubscribe(id);
+    set.p.set({ 0, 0, 0 });
+    set.a.set(0, 7);
+    changes.dispatch();
+    EXPECT_EQ(all, 2);
+    EXPECT_EQ(px, 1);
+    EXPECT_EQ(a, 1);
+}
+
+TEST(Observe, DirtyOnly)
+{
+    settings_t settings;
+    set_example(settings);
+    settings_c set(settings);
+
+    dirty_tracker dirty(set);
+    EXPECT_FALSE(dirty.dirty());
+
+    std::stringstream edits("p.Y = 1\n");
+    edits >> set;
+    set.d.float_value(5.5);
+    set.a.set(1, 7);
+    EXPECT_TRUE(dirty.dirty());
+    std::vector<std::string> paths = { "a", "d", "p.Y" };
+    EXPECT_EQ(dirty.dirty_paths(), paths);
+
+    std::stringstream out;
+    print_marked(out, set);
+    EXPECT_EQ(out.str(), "a = { 1, 7, 3 }\nd = 5.5\np.Y = 1\n");
+
+    std::stringstream grouped;
+    print_marked(grouped, set, text_format::GROUPED);
+    EXPECT_EQ(grouped.str(), "a = { 1, 7, 3 }\nd = 5.5\np { Y = 1 }\n");
+
+    // only the marked fields are saved
+    other_settings_t other;
+    memset(&other, 0, sizeof(other));
+    set.save_marked_into(&other);
+    EXPECT_EQ(other.a[1], 7);
+    EXPECT_EQ(other.d, 5.5);
+    EXPECT_EQ(other.s.y, 1); // the struct is mapped as a whole
+    EXPECT_EQ(other.s.x, 10);
+    EXPECT_EQ(other.i, 0);
+    EXPECT_EQ(other.x, 0);
+
+    // the struct assigned as a whole
+    dirty.clear_dirty();
+    set.s.set({ 1, 2, 3 });
+    memset(&other, 0, sizeof(other));
+    set.save_marked_into(&other);
+    EXPECT_EQ(other.z, 3);
+    EXPECT_EQ(other.s.x, 0);
+    EXPECT_EQ(other.d, 0);
+
+    dirty.clear_dirty();
+    EXPECT_FALSE(dirty.dirty());
+    std::stringstream none;
+    print_marked(none, set);
+    EXPECT_EQ(none.str(), "");
+}
+
+struct block_t
+{
+    point_t a, b, c, d, e, f, g, h;
+};
+
+STRUCT_FIELDS(block_t)
+{
+    STRUCT_FIELD(a, with_name("a"));
+    STRUCT_FIELD(b, with_name("b"));
+    STRUCT_FIELD(c, with_name("c"));
+    STRUCT_FIELD(d, with_name("d"));
+    STRUCT_FIELD(e, with_name("e"));
+    STRUCT_FIELD(f, with_name("f"));
+    STRUCT_FIELD(g, with_name("g"));
+    STRUCT_FIELD(h, with_name("h"));
+};
+
+struct wide_t
+{
+    block_t x, y, z;
+    int32_t tail;
+};
+
+STRUCT_FIELDS(wide_t)
+{
+    STRUCT_FIELD(x, with_name("x"));
+    STRUCT_FIELD(y, with_name("y"));
+    STRUCT_FIELD(z, with_name("z"));
+    STRUCT_FIELD(tail, with_default(0));
+};
+
+TEST(Observe, DirtyWords)
+{
+    // 100 fields in two words of the bitset
+    wide_t wide{};
+    mirror<wide_t, simple_fields> set(wide);
+    dirty_tracker dirty(set);
+
+    std::stringstream edits("x.a.X = 1\nz.h.Z = 2\ntail = 3\n");
+    while (!edits.eof())
+        edits >> set;
+    std::vector<std::string> paths = { "x.a.X", "z.h.Z", "tail" };
+    EXPECT_EQ(dirty.dirty_paths(), paths);
+
+    std::stringstream out;
+    print_marked(out, set);
+    EXPECT_EQ(out.str(), "x.a.X = 1\nz.h.Z = 2\ntail = 3\n");
+
+    std::stringstream grouped;
+    print_marked(grouped, set.z, text_format::GROUPED);
+    EXPECT_EQ(grouped.str(), "h { Z = 2 }\n");
+}
+
+TEST(Observe, DirtyAndObserver)
+{
+    settings_t settings;
+    set_example(settings);
+    settings_c set(settings);
+
+    dirty_tracker dirty(set);
+    int calls = 0;
+    {
+        observer changes(set);
+        changes.subscribe("p", [&](const change_set&) { calls++; });
+
+        // both see the change, dispatch() keeps the dirty fields
+        std::stringstream y("p.Y = 1\n");
+        y >> set;
+        changes.dispatch();
+        EXPECT_EQ(calls, 1);
+        std::vector<std::string> paths = { "p.Y" };
+        EXPECT_EQ(dirty.dirty_paths(), paths);
+
+        // clear_dirty() keeps the changes of the observer
+        std::stringstream z("p.Z = 2\n");
+        z >> set;
+        dirty.clear_dirty();
+        changes.dispatch();
+        EXPECT_EQ(calls, 2);
+    }
+
+    // the tracker outlives the observer
+    set.d.float_value(5.5);
+    std::vector<std::string> paths = { "d" };
+    EXPECT_EQ(dirty.dirty_paths(), paths);
+    EXPECT_TRUE(has_marked(set));
+    EXPECT_FALSE(has_marked(set.p));
+}
+
+// layout report
+
+struct padded_t
+{
+    char a;
+    double b;
+    char c;
+    int32_t d;
+    std::array<char, 30> name;
+    point_t p;
+    char e;
+};
+
+STRUCT_FIELDS(padded_t)
+{
+    STRUCT_FIELD(a, with_default('a'));
+    STRUCT_FIELD(b, with_default(0.0));
+    STRUCT_FIELD(c, with_default('c'));
+    STRUCT_FIELD(d, with_default(0));
+    STRUCT_FIELD(name, with_name("name"));
+    STRUCT_FIELD(p, with_name("p"));
+    STRUCT_FIELD(e, with_default('e'));
+};
+
+struct tagged_t
+{
+    char tag[24];
+};
+
+STRUCT_FIELDS(tagged_t)
+{
+    STRUCT_FIELD(tag, with_name("tag"));
+};
+
+struct tags_t
+{
+    tagged_t items[3];
+};
+
+STRUCT_FIELDS(tags_t)
+{
+    STRUCT_FIELD(items, with_name("items"));
+};
+
+TEST(Layout, Report)
+{
+    auto report = analyze_layout<padded_t>();
+
+    EXPECT_EQ(report.size, sizeof(padded_t));
+    EXPECT_EQ(report.wasted, 7u + 3 + 2 + 3);
+
+    std::vector<std::string> straddles;
+    for (auto& entry : report.entries) {
+        if (entry.straddles)
+            straddles.push_back(entry.path);
+    }
+    EXPECT_EQ(straddles, std::vector<std::string>{ "p" });
+
+    std::vector<std::string> expected = { "b", "p", "d", "name", "a", "c", "e" };
+    EXPECT_EQ(report.suggested, expected);
+    EXPECT_EQ(report.suggested_size, 64u);
+
+    // hot fields first
+    report = analyze_layout<padded_t>(64, { "e", "a" });
+    expected = { "e", "a", "b", "p", "d", "name", "c" };
+    EXPECT_EQ(report.suggested, expected);
+
+    // every element of struct array is checked, the third one straddles
+    report = analyze_layout<tags_t>();
+    straddles.clear();
+    for (auto& entry : report.entries) {
+        if (entry.straddles)
+            straddles.push_back(entry.path);
+    }
+    EXPECT_EQ(straddles, std::vector<std::string>{ "items[].tag" });
+}
+
+// access profiling
+
+#ifdef INTROSPECT_PROFILE
+
+TEST(Profile, Heat)
+{
+    settings_t settings;
+    set_example(settings);
+    settings_c set(settings);
+
+    reset_heat();
+    int64_t sum = 0;
+    std::thread worker([&] {
+        settings_c local(settings);
+        for (int k = 0; k < 100; k++)
+            sum += local.p.x.get();
+    });
+    for (int k = 0; k < 50; k++)
+        set.d.set(k);
+    for (int k = 0; k < 20; k++)
+        sum += set.s.x.get();
+    worker.join();
+    std::ostringstream out;
+    out << set;
+
+    auto report = heat_report();
+    ASSERT_GE(report.size(), 3u);
+    EXPECT_EQ(report[0].type, type_name<settings_t>());
+    EXPECT_EQ(report[0].name, "p.X");
+    EXPECT_EQ(report[0].offset, ptrdiff_t(offsetof(settings_t, p.x)));
+    EXPECT_GE(report[0].count, 100u); // and visits by the printer
+    EXPECT_EQ(report[1].name, "d");
+    EXPECT_GE(report[1].count, 50u);
+    EXPECT_EQ(report[2].name, "s.X");
+    EXPECT_EQ(report[2].offset, ptrdiff_t(offsetof(settings_t, s.x)));
+    EXPECT_LT(report[2].count, 50u);
+    EXPECT_FALSE(heat_overflow());
+}
+
+#endif
+
+// atomic stats
+
+struct latency_t
+{
+    std::atomic<double>     total;
+    std::atomic<int64_t>    count;
+};
+
+STRUCT_FIELDS(latency_t)
+{
+    STRUCT_FIELD(total, with_name("sum"));
+    STRUCT_FIELD(count, with_default(0));
+};
+
+struct stats_t
+{
+    std::atomic<int64_t>    requests;
+    std::array<std::atomic<int32_t>, 2> errors;
+    latency_t               latency;
+    std::string             host;
+};
+
+STRUCT_FIELDS(stats_t)
+{
+    STRUCT_FIELD(requests,  with_default(0));
+    STRUCT_FIELD(errors,    with_name("errors"));
+    STRUCT_FIELD(latency,   with_name("latency"));
+    STRUCT_FIELD(host,      with_name("host"));
+};
+
+TEST(Stats, Prometheus)
+{
+    stats_t stats{};
+    mirror<stats_t, simple_fields> set(stats);
+    prometheus_exporter exporter(set, "svc");
+    EXPECT_EQ(exporter.count(), 5u);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&stats] {
+            for (int k = 0; k < 1000; k++)
+                stats.requests.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    for (auto& worker : workers)
+        worker.join();
+
+    stats.errors[1] = 3;
+    set.latency.total.float_value(1.5);
+    set.latency.count.int_value(4);
+    EXPECT_EQ(stats.latency.count, 4);
+
+    auto& text = exporter.scrape();
+    EXPECT_EQ(text,
+        "svc_requests 4000\n"
+        "svc_errors{index=\"0\"} 0\n"
+        "svc_errors{index=\"1\"} 3\n"
+        "svc_latency_sum 1.5\n"
+        "svc_latency_count 4\n");
+
+    // the buffer is reused
+    auto *data = text.data();
+    set.requests.set_default();
+    EXPECT_EQ(stats.requests, 0);
+    EXPECT_EQ(exporter.scrape().data(), data);
+    EXPECT_EQ(text.substr(0, 15), "svc_requests 0\n");
+}
+
+// runtime-defined structs
+
+TEST(Dynamic, SaveLoadCompare)
+{
+    static enum_options<enum_t> modes;
+    dynamic_schema point("point");
+    point.add_int("X", 4).add_int("Y", 4);
+
+    dynamic_schema plugin("plugin");
+    plugin.add_bool("enabled")
+        .add_int("port", 2, false)
+        .add_float("ratio", 8)
+        .add_enum("mode", array_cast<enum_option>(modes))
+        .add_string("name")
+        .add_int("levels", 1, true, 3)
+        .add_struct("origin", schema::of<point_t>())
+        .add_struct("pts", point, 2);
+    EXPECT_EQ(plugin.at("port").offset, 2);
+    EXPECT_EQ(plugin.at("ratio").offset, 8);
+    EXPECT_EQ(plugin.at("mode").offset, 16);
+    EXPECT_EQ(plugin.align(), 8u);
+    EXPECT_EQ(plugin.size() % 8, 0u);
+    EXPECT_EQ(point.size(), 8u);
+
+    const char *text =
+        "enabled = 1\n"
+        "port = 8080\n"
+        "ratio = 0.5\n"
+        "mode = VALUE1\n"
+        "name = \"alpha\"\n"
+        "levels = { 1, 2, 3 }\n"
+        "origin.X = 4\n"
+        "origin.Y = 5\n"
+        "origin.Z = 6\n"
+        "pts[0].X = 0\n"
+        "pts[0].Y = 0\n"
+        "pts[1].X = 0\n"
+        "pts[1].Y = 7\n";
+
+    dynamic_struct_mirror settings(plugin);
+    std::stringstream in(text);
+    while (!in.eof())
+        in >> settings;
+    std::ostringstream out;
+    out << settings;
+    EXPECT_EQ(out.str(), text);
+
+    // flat table, resolved once
+    size_t y = settings.index_of("origin.Y");
+    EXPECT_EQ(settings.path_of(y), "origin.Y");
+    EXPECT_EQ(mirror_cast<int_mirror>(&settings.field(y))->int_value(), 5);
+    EXPECT_THROW(settings.index_of("origin.W"), bad_key_error);
+
+    // compiled paths and typed views of the buffer
+    auto *base = static_cast<uint8_t *>(settings.addr());
+    EXPECT_EQ(compile_path(plugin, "pts[1].Y").get_int(base), 7);
+    EXPECT_EQ(reinterpret_cast<point_t *>(base + plugin.at("origin").offset)->z, 6);
+
+    // rebinding to external value
+    std::vector<uint8_t> other(plugin.size());
+    dynamic_struct_mirror::construct(plugin, other.data());
+    settings.addr(other.data());
+    mirror_cast<int_mirror>(&settings.field(y))->int_value(9);
+    EXPECT_EQ(compile_path(plugin, "origin.Y").get_int(other.data()), 9);
+    dynamic_struct_mirror::destroy(plugin, other.data());
+
+    // schemas at the same address don't share compiled paths
+    for (bool is_float : { false, true }) {
+        dynamic_schema temp("temp");
+        if (is_float)
+            temp.add_float("v", 8);
+        else
+            temp.add_int("v", 4);
+        EXPECT_EQ(compile_path(temp, "v").kind, is_float ? value_kind::FLOAT : value_kind::INT);
+    }
+
+    // fields added after use make a new layout
+    dynamic_schema grown("grown");
+    grown.add_int("a", 4);
+    auto generation = grown.generation();
+    EXPECT_EQ(compile_path(grown, "a").offset, 0);
+    grown.add_int("b", 4);
+    EXPECT_NE(grown.generation(), generation);
+    EXPECT_EQ(compile_path(grown, "b").offset, 4);
+}
+
+// sorting by path
+
+TEST(Sort, ByPath)
+{
+    std::vector<settings_t> records(1000);
+    uint32_t seed = 1;
+    for (size_t k = 0; k < records.size(); k++) {
+        seed = seed * 1103515245 + 12345;
+        set_default(records[k]);
+        records[k].p.x = int32_t(seed >> 16) % 50 - 25;
+        records[k].d = double(int32_t(seed >> 8) % 1000) / 8 - 60;
+        records[k].s.x = int32_t(k); // original position
+    }
+    auto copy = records;
+
+    sort_by(records, "p.X");
+    for (size_t k = 1; k < records.size(); k++) {
+        auto& a = records[k - 1];
+        auto& b = records[k];
+        ASSERT_LE(a.p.x, b.p.x);
+        if (a.p.x == b.p.x) { // stable
+            ASSERT_LT(a.s.x, b.s.x);
+        }
+    }
+
+    auto index = sort_index(copy, "d");
+    ASSERT_EQ(index.size(), copy.size());
+    for (size_t k = 1; k < index.size(); k++)
+        ASSERT_LE(copy[index[k - 1]].d, copy[index[k]].d);
+    EXPECT_LT(copy[index.front()].d, 0);
+
+    // composite key
+    index = sort_index(copy, "p.X, d");
+    for (size_t k = 1; k < index.size(); k++) {
+        auto& a = copy[index[k - 1]];
+        auto& b = copy[index[k]];
+        ASSERT_TRUE(a.p.x < b.p.x || (a.p.x == b.p.x && a.d <= b.d));
+    }
+
+    EXPECT_THROW(sort_index(copy, "p.W"), bad_key_error);
+}
+
+// bit-packed records
+
+struct sample_t
+{
+    bool        valid;
+    enum_t      mode;
+    int32_t     level;
+    int16_t     delta;
+    uint8_t     kind;
+    std::array<uint8_t, 2> flags;
+    float       weight;
+};
+
+STRUCT_FIELDS(sample_t)
+{
+    STRUCT_FIELD(valid,     with_default(false));
+    STRUCT_FIELD(mode,      with_default(VALUE0));
+    STRUCT_FIELD(level,     with_range(0, 1000));
+    STRUCT_FIELD(delta,     with_range(-8, 7));
+    STRUCT_FIELD(kind,      with_one_of(1, 2, 4));
+    STRUCT_FIELD(flags,     with_range(0, 3));
+    STRUCT_FIELD(weight,    with_default(0.0f));
+};
+
+TEST(Packed, Records)
+{
+    auto& codec = packed_codec::of<sample_t>();
+    EXPECT_EQ(codec.count(), 8u);
+    EXPECT_EQ(codec[codec.index_of("level")].bits, 10u);
+    EXPECT_EQ(codec[codec.index_of("delta")].bits, 4u);
+    EXPECT_EQ(codec[codec.index_of("kind")].bits, 2u);
+    EXPECT_EQ(codec[codec.index_of("flags[1]")].bits, 2u);
+    EXPECT_EQ(codec.bits(), 1u + 1 + 10 + 4 + 2 + 2 + 2 + 32);
+
+    std::vector<sample_t> records(1000);
+    for (size_t k = 0; k < records.size(); k++) {
+        auto& r = records[k];
+        r = {};
+        r.valid = k % 3 == 0;
+        r.mode = k % 2 ? VALUE1 : VALUE0;
+        r.level = int32_t(k);
+        r.delta = int16_t(k % 16) - 8;
+        r.kind = uint8_t(1 << k % 3);
+        r.flags = { uint8_t(k % 4), uint8_t(3 - k % 4) };
+        r.weight = float(k) / 4;
+    }
+
+    packed_vector<sample_t> packed(records);
+    EXPECT_LE(packed.memory() * 2, records.size() * sizeof(sample_t));
+
+    auto equal = [](const sample_t& a, const sample_t& b) {
+        return a.valid == b.valid && a.mode == b.mode && a.level == b.level && a.delta == b.delta &&
+            a.kind == b.kind && a.flags == b.flags && a.weight == b.weight;
+    };
+    for (size_t k = 0; k < records.size(); k++)
+        ASSERT_TRUE(equal(packed[k], records[k])) << k;
+
+    // bulk
+    std::vector<sample_t> unpacked(records.size());
+    std::vector<uint64_t> stream(codec.words(records.size()));
+    codec.pack(records.data(), records.size(), sizeof(sample_t), stream.data());
+    codec.unpack(stream.data(), records.size(), unpacked.data(), sizeof(sample_t));
+    for (size_t k = 0; k < records.size(); k++)
+        ASSERT_TRUE(equal(unpacked[k], records[k])) << k;
+
+    // random access to single field
+    size_t delta = codec.index_of("delta");
+    EXPECT_EQ(packed.get_int(17, delta), 17 % 16 - 8);
+    packed.set_int(17, delta, -3);
+    EXPECT_EQ(packed[17].delta, -3);
+    EXPECT_EQ(packed[17].level, 17);
+    EXPECT_EQ(packed[18].delta, 18 % 16 - 8);
+    EXPECT_EQ(packed.get_float(999, codec.index_of("weight")), 999.0 / 4);
+
+    EXPECT_THROW(packed.set_int(0, delta, 8), bad_value_error);
+    records[0].level = 1001;
+    EXPECT_THROW(packed.push_back(records[0]), bad_value_error);
+    EXPECT_EQ(packed.size(), 1000u);
+}
+
+// a field of single value takes no bits, here at the end of the stream
+struct versioned_t
+{
+    int64_t     id;
+    uint8_t     version;
+};
+
+STRUCT_FIELDS(versioned_t)
+{
+    STRUCT_FIELD(id,        with_default(0));
+    STRUCT_FIELD(version,   with_range(3, 3));
+};
+
+TEST(Packed, ZeroBits)
+{
+    auto& codec = packed_codec::of<versioned_t>();
+    size_t version = codec.index_of("version");
+    EXPECT_EQ(codec[version].bits, 0u);
+    EXPECT_EQ(codec.bits(), 64u);
+
+    packed_vector<versioned_t> packed;
+    packed.push_back({ -5, 3 });
+    EXPECT_EQ(packed.memory(), sizeof(uint64_t));
+    EXPECT_EQ(packed[0].id, -5);
+    EXPECT_EQ(packed[0].version, 3);
+    EXPECT_EQ(packed.get_int(0, version), 3);
+    packed.set_int(0, version, 3);
+    EXPECT_THROW(packed.set_int(0, version, 4), bad_value_error);
+    EXPECT_EQ(packed[0].id, -5);
+}
+
+// parallel traversal
+
+struct shard_t
+{
+    int32_t                 id;
+    std::vector<int32_t>    counts;
+};
+
+STRUCT_FIELDS(shard_t)
+{
+    STRUCT_FIELD(id,     with_name("id"));
+    STRUCT_FIELD(counts, with_name("counts"));
+};
+
+struct cluster_t
+{
+    int32_t                 version;
+    point_t                 origin;
+    std::array<point_t, 600> points;
+    shard_t                 primary;
+    int64_t                 epoch;
+};
+
+STRUCT_FIELDS(cluster_t)
+{
+    STRUCT_FIELD(version, with_default(1));
+    STRUCT_FIELD(origin,  with_name("origin"));
+    STRUCT_FIELD(points,  with_name("points"));
+    STRUCT_FIELD(primary, with_name("primary"));
+    STRUCT_FIELD(epoch,   with_default(0));
+};
+
+struct sum_visitor : parallel_visitor
+{
+    int64_t sum = 0;
+    size_t count = 0;
+    std::vector<std::string> paths;
+
+    std::unique_ptr<parallel_visitor> fork() const override {
+        return std::unique_ptr<parallel_visitor>(new sum_visitor);
+    }
+
+    void join(parallel_visitor& part) override {
+        auto& that = static_cast<sum_visitor&>(part);
+        sum += that.sum;
+        count += that.count;
+        paths.insert(paths.end(), that.paths.begin(), that.paths.end());
+    }
+
+    void visit_field(const char *path, const base_mirror& value) override {
+        paths.push_back(path);
+        value.visit(*this);
+    }
+
+    void visit_element(const char *path, size_t i, const base_mirror& value) override {
+        if (i == 0)
+            paths.push_back(std::string(path) + "[]");
+        value.visit(*this);
+    }
+
+    using const_visitor::visit;
+
+    void visit(const int_mirror& value) override {
+        sum += value.int_value();
+        count++;
+    }
+
+    void visit(const array_mirror& value) override {
+        for (size_t i = 0; i < value.count(); i++)
+            value[i].visit(*this);
+    }
+
+    void visit(const struct_mirror& value) override {
+        for (auto& field : value.fields())
+            field.visit(*this);
+    }
+};
+
+TEST(Parallel, Visit)
+{
+    cluster_t cluster{};
+    cluster.version = 3;
+    cluster.origin = { 1, 2, 3 };
+    for (int i = 0; i < 600; i++)
+        cluster.points[i] = { i, 1, -i };
+    cluster.primary.id = 5;
+    cluster.primary.counts.assign(1000, 2);
+    cluster.epoch = 7;
+
+    sum_visitor single;
+    parallel_visit(cluster, single, 1);
+    EXPECT_EQ(single.sum, 3 + 6 + 600 + 5 + 2000 + 7);
+    EXPECT_EQ(single.count, 1u + 3 + 1800 + 1 + 1000 + 1);
+
+    // nested structs are split, consecutive fields are kept together
+    std::vector<std::string> paths = {
+        "version", "origin.X", "origin.Y", "origin.Z", "points[]", "primary.id", "primary.counts[]", "epoch" };
+    EXPECT_EQ(single.paths, paths);
+
+    sum_visitor parallel;
+    parallel_visit(cluster, parallel, 4);
+    EXPECT_EQ(parallel.sum, single.sum);
+    EXPECT_EQ(parallel.count, single.count);
+    EXPECT_EQ(parallel.paths, paths);
+}
+
+// snapshot log
+
+struct telemetry_t
+{
+    int64_t                 tick;
+    double                  load;
+    float                   temp;
+    std::array<int32_t, 3>  counters;
+    enum_t                  mode;
+    bool                    ok;
+    std::string             state;
+};
+
+STRUCT_FIELDS(telemetry_t)
+{
+    STRUCT_FIELD(tick,     with_default(0));
+    STRUCT_FIELD(load,     with_default(0.0));
+    STRUCT_FIELD(temp,     with_default(0.0f));
+    STRUCT_FIELD(counters, with_name("counters"));
+    STRUCT_FIELD(mode,     with_default(VALUE0));
+    STRUCT_FIELD(ok,       with_default(false));
+    STRUCT_FIELD(state,    with_name("state"));
+};
+
+// the same number of fields, temp of another type
+struct telemetry_v2_t
+{
+    int64_t                 tick;
+    double                  load;
+    double                  temp;
+    std::array<int32_t, 3>  counters;
+    enum_t                  mode;
+    bool                    ok;
+    std::string             state;
+};
+
+STRUCT_FIELDS(telemetry_v2_t)
+{
+    STRUCT_FIELD(tick,     with_default(0));
+    STRUCT_FIELD(load,     with_default(0.0));
+    STRUCT_FIELD(temp,     with_default(0.0));
+    STRUCT_FIELD(counters, with_name("counters"));
+    STRUCT_FIELD(mode,     with_default(VALUE0));
+    STRUCT_FIELD(ok,       with_default(false));
+    STRUCT_FIELD(state,    with_name("state"));
+};
+
+TEST(Snapshot, DeltaLog)
+{
+    std::vector<telemetry_t> series(200);
+    for (int k = 0; k < 200; k++) {
+        auto& t = series[k];
+        t.tick = 1000000 + k;
+        t.load = 0.5 + (k % 10) * 0.125;
+        t.temp = k < 100 ? 36.6f : -40.0f;
+        t.counters = {{ k, 7, -k * 3 }};
+        t.mode = k % 50 < 25 ? VALUE0 : VALUE1;
+        t.ok = k % 7 != 0;
+        t.state = k < 150 ? "running" : "stopping";
+    }
+
+    auto& schema = schema::of<telemetry_t>();
+    std::stringstream log;
+    snapshot_writer writer(schema, log, 16);
+    for (auto& t : series)
+        writer.write(&t);
+    EXPECT_EQ(writer.count(), 200u);
+
+    // deltas are much smaller than the records
+    auto data = log.str();
+    EXPECT_LT(data.size(), series.size() * sizeof(telemetry_t) / 4);
+
+    snapshot_reader reader(schema, data.data(), data.size());
+    ASSERT_EQ(reader.count(), 200u);
+    EXPECT_TRUE(reader.is_keyframe(0));
+    EXPECT_TRUE(reader.is_keyframe(32));
+    EXPECT_FALSE(reader.is_keyframe(33));
+
+    // random seek
+    telemetry_t t{};
+    for (int k : { 199, 0, 37, 150, 149, 16, 100, 15 }) {
+        reader.read(k, &t);
+        auto& e = series[k];
+        EXPECT_EQ(t.tick, e.tick);
+        EXPECT_EQ(t.load, e.load);
+        EXPECT_EQ(t.temp, e.temp);
+        EXPECT_EQ(t.counters, e.counters);
+        EXPECT_EQ(t.mode, e.mode);
+        EXPECT_EQ(t.ok, e.ok);
+        EXPECT_EQ(t.state, e.state);
+    }
+
+    EXPECT_THROW(reader.read(200, &t), bad_idx_error);
+    EXPECT_THROW(snapshot_reader(schema, data.data(), data.size() - 1), parse_error);
+    EXPECT_THROW(snapshot_reader(schema::of<point_t>(), data.data(), data.size()), parse_error);
+
+    // the fingerprint of the schema in the header
+    ASSERT_EQ(snapshot_fields(schema::of<telemetry_v2_t>()).size(), snapshot_fields(schema).size());
+    EXPECT_THROW(snapshot_reader(schema::of<telemetry_v2_t>(), data.data(), data.size()), parse_error);
+}
+
+// real-time subset
+
+// allocations of the thread, counted by the replaced operator new
+thread_local size_t allocations = 0;
+
+void *operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    allocations++;
+    return malloc(size ? size : 1);
+}
+
+void *operator new(size_t size)
+{
+    if (void *ptr = operator new(size, std::nothrow))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void *operator new[](size_t size, const std::nothrow_t&) noexcept { return operator new(size, std::nothrow); }
+
+// gcc doesn't see that the replaced operator new is malloc
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void *ptr) noexcept { free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t&) noexcept { free(ptr); }
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic pop
+#endif
+
+// fails the test on any allocation in the scope
+struct no_allocations
+{
+    size_t start = allocations;
+    ~no_allocations() { EXPECT_EQ(allocations, start) << "allocations in real-time code"; }
+};
+
+// visitors see the elements of struct arrays through the shared mirror
+struct int_sum_visitor : const_visitor
+{
+    int64_t sum = 0;
+
+    using const_visitor::visit;
+
+    void visit(const int_mirror& value) override { sum += value.int_value(); }
+
+    void visit(const array_mirror& value) override {
+        for (size_t i = 0; i < value.count(); i++)
+            value[i].visit(*this);
+    }
+
+    void visit(const struct_mirror& value) override {
+        for (auto& field : value.fields())
+            field.visit(*this);
+    }
+};
+
+TEST(StructArray, VisitInPlace)
+{
+    shape_t shape1;
+    shape1.id = 7;
+    for (int i = 0; i < 3; i++)
+        shape1.pts[i] = { i, 10 * i, 100 * i };
+    mirror<shape_t, simple_fields> shape(shape1);
+
+    int_sum_visitor sum;
+    {
+        no_allocations guard;
+        shape.visit(sum);
+    }
+    EXPECT_EQ(sum.sum, 7 + 3 + 30 + 300);
+}
+
+TEST(RealTime, NoAllocations)
+{
+    settings_t settings;
+    set_example(settings);
+
+    // the paths are resolved off the real-time thread
+    size_t start = allocations;
+    rt_table table(schema::of<settings_t>());
+    EXPECT_GT(allocations, start);
+    EXPECT_EQ(table.count(), 14u);
+    EXPECT_STREQ(table.path(10), "p.Z");
+
+    const char delta[] = "d = 1e-3\ne = VALUE0\n  p.X = -5\n\na = { 1, 2, 0x10 }\r\n";
+    const char mixed[] = "i = 1\nj = x\nc = 65";
+    char text[1024], small[40];
+    size_t applied = 0, written = 0, partial = 0;
+    {
+        no_allocations guard;
+        EXPECT_EQ(rt_apply_delta(table, &settings, delta, sizeof(delta) - 1, &applied), rt_status::OK);
+        EXPECT_EQ(applied, 4u);
+
+        EXPECT_EQ(rt_apply(table, &settings, "q = 1", 5), rt_status::UNKNOWN_PATH);
+        EXPECT_EQ(rt_apply(table, &settings, "c = 300", 7), rt_status::BAD_VALUE);
+        EXPECT_EQ(rt_apply(table, &settings, "b = 2", 5), rt_status::BAD_VALUE);
+        EXPECT_EQ(rt_apply(table, &settings, "e = VALUE7", 10), rt_status::BAD_VALUE);
+        EXPECT_EQ(rt_apply(table, &settings, "p.X 5", 5), rt_status::SYNTAX_ERROR);
+        EXPECT_EQ(rt_apply(table, &settings, "a[0] = 5", 8), rt_status::UNKNOWN_PATH);
+        EXPECT_EQ(rt_apply(table, &settings, "a = { 5, 5 }", 12), rt_status::BAD_VALUE);
+        EXPECT_EQ(rt_apply(table, &settings, "a = { 5, x, 5 }", 15), rt_status::BAD_VALUE);
+        EXPECT_EQ(rt_apply(table, &settings, "a = { 5, 5, 5", 13), rt_status::SYNTAX_ERROR);
+
+        // a bad line doesn't stop the rest
+        EXPECT_EQ(rt_apply_delta(table, &settings, mixed, sizeof(mixed) - 1, &applied), rt_status::BAD_VALUE);
+        EXPECT_EQ(applied, 2u);
+
+        EXPECT_EQ(rt_print(table, &settings, text, sizeof(text), &written), rt_status::OK);
+        EXPECT_EQ(rt_print(table, &settings, small, sizeof(small), &partial), rt_status::BUFFER_FULL);
+    }
+
+    EXPECT_EQ(settings.d, 1e-3);
+    EXPECT_EQ(settings.e, VALUE0);
+    EXPECT_EQ(settings.p.x, -5);
+    EXPECT_EQ(settings.a[2], 16);
+    EXPECT_EQ(settings.i, 1);
+    EXPECT_EQ(settings.j, 9);
+    EXPECT_EQ(settings.c, 'A');
+
+    EXPECT_EQ(std::string(text, written),
+        "a = { 1, 2, 16 }\nb = 1\nc = 65\nd = 0.001\ne = VALUE0\nf = 6.7\n"
+        "i = 1\nj = 9\np.X = -5\np.Y = 11\np.Z = 12\ns.X = 13\ns.Y = 14\ns.Z = 15\n");
+    EXPECT_EQ(std::string(small, partial), "a = { 1, 2, 16 }\nb = 1\nc = 65\n");
+
+    // the printed text is read back to the same values
+    settings_t copy;
+    set_default(copy);
+    EXPECT_EQ(rt_apply_delta(table, &copy, text, written, &applied), rt_status::OK);
+    EXPECT_EQ(applied, 14u);
+    EXPECT_TRUE(copy == settings);
+}
+
+TEST(RealTime, TextFormat)
+{
+    settings_t settings;
+    set_example(settings);
+    // more digits than the default precision of streams
+    settings.d = 0.1234567;
+    settings.f = -2.5e-07f;
+    settings.a[1] = -2;
+    rt_table table(schema::of<settings_t>());
+    settings_c set(settings);
+
+    // the printer and the real-time subset write the same text
+    char text[1024];
+    size_t written = 0, applied = 0;
+    EXPECT_EQ(rt_print(table, &settings, text, sizeof(text), &written), rt_status::OK);
+    std::stringstream printed;
+    printed << set;
+    EXPECT_EQ(std::string(text, written), printed.str());
+    EXPECT_NE(printed.str().find("d = 0.1234567\n"), std::string::npos);
+
+    // the parser reads the text of the real-time subset
+    settings_t parsed;
+    set_default(parsed);
+    settings_c parsed_set(parsed);
+    std::stringstream rt_text(std::string(text, written));
+    while (!rt_text.eof())
+        rt_text >> parsed_set;
+    EXPECT_TRUE(parsed == settings);
+
+    // and the other way
+    settings_t applied_settings;
+    set_default(applied_settings);
+    auto str = printed.str();
+    EXPECT_EQ(rt_apply_delta(table, &applied_settings, str.data(), str.size(), &applied), rt_status::OK);
+    EXPECT_EQ(applied, table.count());
+    EXPECT_TRUE(applied_settings == settings);
+
+    // arrays are listed as a whole, the format has no paths of their elements
+    rt_table listed(schema::of<settings_t>(), { "p.X", "a" });
+    EXPECT_EQ(rt_print(listed, 1, &settings, text, sizeof(text), &written), rt_status::OK);
+    EXPECT_EQ(std::string(text, written), "a = { 1, -2, 3 }\n");
+    EXPECT_THROW(rt_table(schema::of<settings_t>(), { "a[1]" }), bad_key_error);
+}